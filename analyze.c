@@ -0,0 +1,317 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+/*
+ * Headless report-rate and latency analyzer.
+ *
+ *     analyze [-t seconds] [-j] [-r capture]    measure connected devices
+ *     analyze [-j] -p capture                   analyze a recorded capture
+ *
+ * Every button and stick event is collected with its device timestamp and
+ * the time GamepadUpdate decoded it.  Events with the same device timestamp
+ * came in one report; the spacing of reports gives the rate and jitter, and
+ * the decode time minus the device time gives the age of each event.  The
+ * device clock has an unknown offset, so ages are relative to the youngest
+ * event seen: the fastest the pipeline ever delivered.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gamepad.h"
+
+#define CAPTURE_HEADER	"# libgamepad capture 1"
+
+/* A captured event */
+typedef struct SAMPLE SAMPLE;
+struct SAMPLE {
+	int type, input, value, x, y;
+	unsigned int time;			/* device milliseconds */
+	unsigned long long stamp;	/* decode microseconds */
+};
+
+/* Events captured on one device */
+typedef struct CAPTURE CAPTURE;
+struct CAPTURE {
+	SAMPLE* samples;
+	size_t count, capacity;
+};
+
+static CAPTURE CAPTURES[GAMEPAD_COUNT];
+static FILE* RECORD = NULL;
+
+static void add_sample(int device, const SAMPLE* sample) {
+	CAPTURE* capture = &CAPTURES[device];
+	SAMPLE* grown;
+
+	if (capture->count == capture->capacity) {
+		capture->capacity = capture->capacity != 0 ? capture->capacity * 2 : 1024;
+		grown = (SAMPLE*)realloc(capture->samples, capture->capacity * sizeof(SAMPLE));
+		if (grown == NULL) {
+			fprintf(stderr, "analyze: out of memory\n");
+			exit(1);
+		}
+		capture->samples = grown;
+	}
+	capture->samples[capture->count++] = *sample;
+}
+
+static void onevent(const GAMEPAD_EVENT* event, void* user) {
+	SAMPLE sample;
+
+	sample.type = event->type;
+	sample.input = event->input;
+	sample.value = event->value;
+	sample.x = event->x;
+	sample.y = event->y;
+	sample.time = event->time;
+	sample.stamp = event->stamp;
+	add_sample(event->device, &sample);
+
+	if (RECORD != NULL) {
+		fprintf(RECORD, "%d %d %d %d %d %d %u %llu\n", event->device, sample.type, sample.input,
+			sample.value, sample.x, sample.y, sample.time, sample.stamp);
+	}
+}
+
+static int read_capture(const char* path) {
+	char line[256];
+	SAMPLE sample;
+	int device;
+	FILE* file = fopen(path, "r");
+
+	if (file == NULL) {
+		fprintf(stderr, "analyze: cannot open %s\n", path);
+		return 0;
+	}
+	if (fgets(line, sizeof(line), file) == NULL || strncmp(line, CAPTURE_HEADER, strlen(CAPTURE_HEADER)) != 0) {
+		fprintf(stderr, "analyze: %s is not a capture\n", path);
+		fclose(file);
+		return 0;
+	}
+	while (fgets(line, sizeof(line), file) != NULL) {
+		if (sscanf(line, "%d %d %d %d %d %d %u %llu", &device, &sample.type, &sample.input,
+				&sample.value, &sample.x, &sample.y, &sample.time, &sample.stamp) == 8 &&
+				device >= 0 && device < GAMEPAD_COUNT) {
+			add_sample(device, &sample);
+		}
+	}
+	fclose(file);
+	return 1;
+}
+
+static int compare_long(const void* a, const void* b) {
+	long long x = *(const long long*)a, y = *(const long long*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* Percentile of a sorted array */
+static long long percentile(const long long* values, size_t count, int p) {
+	return count != 0 ? values[(count - 1) * p / 100] : 0;
+}
+
+/* Statistics of one device */
+typedef struct REPORT REPORT;
+struct REPORT {
+	size_t events, reports;
+	double rate;						/* reports per second */
+	long long interval[4];				/* p50, p90, p99 and max in microseconds */
+	long long jitter[3];				/* p50, p99 and max distance from the median interval */
+	double burstMean;
+	long long burst[2];					/* p50 and max events per report */
+	long long age[4];					/* p50, p90, p99 and max in microseconds */
+};
+
+static int analyze_device(const CAPTURE* capture, REPORT* report) {
+	long long* intervals;
+	long long* jitter;
+	long long* bursts;
+	long long* ages;
+	long long offset, d;
+	size_t i, n, burst, spanned;
+	unsigned int first;
+
+	memset(report, 0, sizeof(*report));
+	report->events = capture->count;
+	if (capture->count == 0) {
+		return 0;
+	}
+
+	intervals = (long long*)malloc(capture->count * sizeof(long long));
+	jitter = (long long*)malloc(capture->count * sizeof(long long));
+	bursts = (long long*)malloc(capture->count * sizeof(long long));
+	ages = (long long*)malloc(capture->count * sizeof(long long));
+	if (intervals == NULL || jitter == NULL || bursts == NULL || ages == NULL) {
+		fprintf(stderr, "analyze: out of memory\n");
+		exit(1);
+	}
+
+	/* group events into reports by device timestamp; differences wrap with the 32-bit clock */
+	n = 0;
+	burst = 1;
+	first = capture->samples[0].time;
+	for (i = 1; i <= capture->count; ++i) {
+		if (i == capture->count || capture->samples[i].time != capture->samples[i - 1].time) {
+			bursts[report->reports++] = (long long)burst;
+			burst = 1;
+			if (i != capture->count) {
+				intervals[n++] = (long long)(unsigned int)(capture->samples[i].time - capture->samples[i - 1].time) * 1000;
+			}
+		} else {
+			++burst;
+		}
+	}
+	spanned = (size_t)(unsigned int)(capture->samples[capture->count - 1].time - first);
+	report->rate = spanned != 0 ? (double)(report->reports - 1) * 1000.0 / (double)spanned : 0.0;
+
+	qsort(intervals, n, sizeof(long long), compare_long);
+	report->interval[0] = percentile(intervals, n, 50);
+	report->interval[1] = percentile(intervals, n, 90);
+	report->interval[2] = percentile(intervals, n, 99);
+	report->interval[3] = n != 0 ? intervals[n - 1] : 0;
+	for (i = 0; i != n; ++i) {
+		d = intervals[i] - report->interval[0];
+		jitter[i] = d < 0 ? -d : d;
+	}
+	qsort(jitter, n, sizeof(long long), compare_long);
+	report->jitter[0] = percentile(jitter, n, 50);
+	report->jitter[1] = percentile(jitter, n, 99);
+	report->jitter[2] = n != 0 ? jitter[n - 1] : 0;
+
+	report->burstMean = (double)capture->count / (double)report->reports;
+	qsort(bursts, report->reports, sizeof(long long), compare_long);
+	report->burst[0] = percentile(bursts, report->reports, 50);
+	report->burst[1] = bursts[report->reports - 1];
+
+	/* the youngest event defines the clock offset */
+	offset = 0;
+	for (i = 0; i != capture->count; ++i) {
+		d = (long long)capture->samples[i].stamp - (long long)(capture->samples[i].time - first) * 1000;
+		if (i == 0 || d < offset) {
+			offset = d;
+		}
+		ages[i] = d;
+	}
+	for (i = 0; i != capture->count; ++i) {
+		ages[i] -= offset;
+	}
+	qsort(ages, capture->count, sizeof(long long), compare_long);
+	report->age[0] = percentile(ages, capture->count, 50);
+	report->age[1] = percentile(ages, capture->count, 90);
+	report->age[2] = percentile(ages, capture->count, 99);
+	report->age[3] = ages[capture->count - 1];
+
+	free(intervals);
+	free(jitter);
+	free(bursts);
+	free(ages);
+	return 1;
+}
+
+static void print_text(int device, const REPORT* r) {
+	printf("device %d: %lu events in %lu reports, %.1f reports/s\n", device,
+		(unsigned long)r->events, (unsigned long)r->reports, r->rate);
+	printf("  interval us: p50 %lld, p90 %lld, p99 %lld, max %lld\n", r->interval[0], r->interval[1], r->interval[2], r->interval[3]);
+	printf("  jitter us:   p50 %lld, p99 %lld, max %lld\n", r->jitter[0], r->jitter[1], r->jitter[2]);
+	printf("  burst:       mean %.2f, p50 %lld, max %lld events\n", r->burstMean, r->burst[0], r->burst[1]);
+	printf("  age us:      p50 %lld, p90 %lld, p99 %lld, max %lld\n", r->age[0], r->age[1], r->age[2], r->age[3]);
+}
+
+static void print_json(int device, const REPORT* r, int first) {
+	printf("%s\n    {\"device\": %d, \"events\": %lu, \"reports\": %lu, \"rate\": %.2f,\n", first ? "" : ",", device,
+		(unsigned long)r->events, (unsigned long)r->reports, r->rate);
+	printf("     \"interval_us\": {\"p50\": %lld, \"p90\": %lld, \"p99\": %lld, \"max\": %lld},\n",
+		r->interval[0], r->interval[1], r->interval[2], r->interval[3]);
+	printf("     \"jitter_us\": {\"p50\": %lld, \"p99\": %lld, \"max\": %lld},\n", r->jitter[0], r->jitter[1], r->jitter[2]);
+	printf("     \"burst\": {\"mean\": %.2f, \"p50\": %lld, \"max\": %lld},\n", r->burstMean, r->burst[0], r->burst[1]);
+	printf("     \"age_us\": {\"p50\": %lld, \"p90\": %lld, \"p99\": %lld, \"max\": %lld}}",
+		r->age[0], r->age[1], r->age[2], r->age[3]);
+}
+
+static void usage(void) {
+	fprintf(stderr, "usage: analyze [-t seconds] [-j] [-r capture]\n"
+		"       analyze [-j] -p capture\n");
+	exit(2);
+}
+
+int main(int argc, char** argv) {
+	const char* recordPath = NULL;
+	const char* replayPath = NULL;
+	int seconds = 10, json = 0, first = 1, i;
+	unsigned long long end;
+	REPORT report;
+
+	for (i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			seconds = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-j") == 0) {
+			json = 1;
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			recordPath = argv[++i];
+		} else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			replayPath = argv[++i];
+		} else {
+			usage();
+		}
+	}
+
+	if (replayPath != NULL) {
+		if (!read_capture(replayPath)) {
+			return 1;
+		}
+	} else {
+		if (recordPath != NULL) {
+			RECORD = fopen(recordPath, "w");
+			if (RECORD == NULL) {
+				fprintf(stderr, "analyze: cannot create %s\n", recordPath);
+				return 1;
+			}
+			fprintf(RECORD, CAPTURE_HEADER "\n");
+		}
+
+		/* raw input only; derived events carry the time of the update, not of a report */
+		GamepadInit();
+		GamepadSubscribe(GAMEPAD_MASK_ALL,
+			GAMEPAD_MASK(EVENT_BUTTON_DOWN) | GAMEPAD_MASK(EVENT_BUTTON_UP) | GAMEPAD_MASK(EVENT_AXIS),
+			GAMEPAD_MASK_ALL, 0, onevent, NULL);
+
+		fprintf(stderr, "analyze: recording for %d seconds, move the sticks\n", seconds);
+		end = GamepadClock() + (unsigned long long)seconds * 1000000;
+		while (GamepadClock() < end) {
+			GamepadWait(10);
+			GamepadUpdate();
+		}
+
+		GamepadShutdown();
+		if (RECORD != NULL) {
+			fclose(RECORD);
+		}
+	}
+
+	if (json) {
+		printf("{\"devices\": [");
+	}
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		if (analyze_device(&CAPTURES[i], &report)) {
+			if (json) {
+				print_json(i, &report, first);
+			} else {
+				print_text(i, &report);
+			}
+			first = 0;
+		}
+		free(CAPTURES[i].samples);
+	}
+	if (json) {
+		printf("\n]}\n");
+	} else if (first) {
+		printf("no events captured\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,626 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+/*
+ * Microbenchmarks.  Run "bench" for all of them or "bench <name>..." for some.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gamepad.hpp"
+
+/* Unity builds see the library's internals, for the state benchmark */
+#if defined(BENCH_UNITY)
+#	include "gamepad_all.c"
+#endif
+
+#if defined(__linux__)
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/ioctl.h>
+#	include <sys/syscall.h>
+#	include <linux/input.h>
+#	include <linux/perf_event.h>
+#endif
+
+/* Which build of the library this binary is linked against */
+#if !defined(BENCH_LIBRARY)
+#	define BENCH_LIBRARY "shared"
+#endif
+
+/* Frames simulated per measurement */
+static const int FRAMES = 1000000;
+
+/* Keeps results alive without the compiler seeing through them */
+static volatile unsigned int KEEP;
+
+/* Benchmarks that also check a result count their failures here */
+static int BENCH_FAILURES = 0;
+
+/* Run a function once per frame and return nanoseconds per frame */
+template <typename F>
+static double measure(F frame) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i != FRAMES; ++i) {
+		frame();
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / FRAMES;
+}
+
+/* A typical frame's worth of queries through the exported C functions */
+static void benchAccessors() {
+	double c = measure([] {
+		unsigned int r = 0;
+		r += GamepadButtonDown(GAMEPAD_0, BUTTON_A);
+		r += GamepadButtonTriggered(GAMEPAD_0, BUTTON_B);
+		r += GamepadButtonReleased(GAMEPAD_0, BUTTON_X);
+		r += GamepadButtonDown(GAMEPAD_0, BUTTON_A) || GamepadButtonDown(GAMEPAD_0, BUTTON_B) || GamepadButtonDown(GAMEPAD_0, BUTTON_X);
+		r += GamepadButtonDown(GAMEPAD_0, BUTTON_LEFT_SHOULDER) && GamepadButtonDown(GAMEPAD_0, BUTTON_RIGHT_SHOULDER);
+		r += GamepadTriggerDown(GAMEPAD_0, TRIGGER_LEFT);
+		r += GamepadStickDirTriggered(GAMEPAD_0, STICK_LEFT, STICKDIR_UP);
+		r += GamepadStickLength(GAMEPAD_0, STICK_LEFT) > 0.5f;
+		KEEP = r;
+	});
+
+	gamepad::pad<GAMEPAD_0> pad;
+	double cpp = measure([&pad] {
+		unsigned int r = 0;
+		pad.refresh();
+		r += pad.down<BUTTON_A>();
+		r += pad.triggered<BUTTON_B>();
+		r += pad.released<BUTTON_X>();
+		r += pad.anyDown<BUTTON_A, BUTTON_B, BUTTON_X>();
+		r += pad.allDown<BUTTON_LEFT_SHOULDER, BUTTON_RIGHT_SHOULDER>();
+		r += pad.triggerDown<TRIGGER_LEFT>();
+		r += pad.stickDirTriggered<STICK_LEFT, STICKDIR_UP>();
+		r += pad.stickLength<STICK_LEFT>() > 0.5f;
+		KEEP = r;
+	});
+
+	std::printf("[" BENCH_LIBRARY "] accessors: C calls %.1f ns/frame, C++ snapshot %.1f ns/frame\n", c, cpp);
+}
+
+/* Fake force feedback device recording when each level change arrives */
+struct RUMBLE_RECORD {
+	unsigned long long stamp;
+	unsigned short strong, weak;
+};
+
+static GAMEPAD_BOOL recordRumble(GAMEPAD_DEVICE, unsigned short strong, unsigned short weak, void* user) {
+	auto* records = static_cast<std::vector<RUMBLE_RECORD>*>(user);
+	if (records->size() < records->capacity()) {
+		records->push_back({ GamepadClock(), strong, weak });
+	}
+	return GAMEPAD_TRUE;
+}
+
+/*
+ * Timing of waveform playback against a fake device; every sample differs so
+ * each one is written.  Fails unless every sample arrived once and in order,
+ * with no underrun before the last one.
+ */
+static void benchWaveform() {
+	const unsigned int RATE = 1000, CAPACITY = 250, SAMPLES = 2000;
+	std::vector<unsigned short> samples(SAMPLES * 2);
+	std::vector<RUMBLE_RECORD> records;
+
+	for (unsigned int i = 0; i != SAMPLES; ++i) {
+		samples[i * 2] = static_cast<unsigned short>(i + 1);
+		samples[i * 2 + 1] = static_cast<unsigned short>(SAMPLES - i);
+	}
+	/* room for duplicates, so they show up as failures rather than being cut off */
+	records.reserve(SAMPLES * 2);
+	GamepadSetRumbleSink(recordRumble, &records);
+
+	GAMEPAD_WAVEFORM* waveform = GamepadWaveformCreate(GAMEPAD_0, RATE, CAPACITY);
+	unsigned int queued = GamepadWaveformQueue(waveform, samples.data(), CAPACITY);
+	queued += GamepadWaveformQueue(waveform, samples.data() + queued * 2, CAPACITY);
+
+	unsigned long long start = GamepadClock() + 5000;
+	GamepadWaveformStart(waveform, start);
+
+	/* refill from a frame loop running slower than the sample rate */
+	while (GamepadWaveformPosition(waveform) < SAMPLES) {
+		if (queued < SAMPLES) {
+			queued += GamepadWaveformQueue(waveform, samples.data() + queued * 2, SAMPLES - queued);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(16));
+	}
+	GamepadWaveformStop(waveform);
+	/* ticks after the last sample count as underruns too */
+	unsigned int underruns = GamepadWaveformUnderruns(waveform) - (GamepadWaveformPosition(waveform) - SAMPLES);
+	GamepadWaveformDestroy(waveform);
+	GamepadSetRumbleSink(nullptr, nullptr);
+
+	/* sample n was due at start + n / rate; an underrun shows up as a write of zero */
+	std::vector<long long> late;
+	unsigned int misplaced = 0, silences = 0;
+	for (const RUMBLE_RECORD& r : records) {
+		if (r.strong == 0) {
+			silences += late.size() < SAMPLES;
+			continue;
+		}
+		unsigned int n = r.strong - 1u;
+		misplaced += n != late.size() || r.weak != SAMPLES - n;
+		late.push_back(static_cast<long long>(r.stamp - (start + n * 1000000ull / RATE)));
+	}
+	if (late.empty()) {
+		std::printf("[" BENCH_LIBRARY "] waveform: FAILED, no samples recorded\n");
+		++BENCH_FAILURES;
+		return;
+	}
+	std::sort(late.begin(), late.end());
+
+	bool failed = late.size() != SAMPLES || misplaced != 0 || silences != 0 || underruns != 0;
+	BENCH_FAILURES += failed;
+	std::printf("[" BENCH_LIBRARY "] waveform: %s, %zu of %u samples written, %u misplaced, %u underruns, "
+		"lateness p50 %lld us, p99 %lld us, max %lld us\n",
+		failed ? "FAILED" : "ok", late.size(), SAMPLES, misplaced, underruns + silences,
+		late[late.size() / 2], late[late.size() * 99 / 100], late.back());
+}
+
+/* Cost of a gesture symbol as the number of registered patterns grows */
+static void benchGestures() {
+	static const char* TOKENS[] = { "1", "2", "3", "4", "6", "7", "8", "9", "a", "b", "x", "y", "-a", "[b]" };
+	static const int SYMBOLS[] = {
+		GAMEPAD_GESTURE_DIR(1), GAMEPAD_GESTURE_DIR(2), GAMEPAD_GESTURE_DIR(3), GAMEPAD_GESTURE_DIR(4),
+		GAMEPAD_GESTURE_DIR(6), GAMEPAD_GESTURE_DIR(7), GAMEPAD_GESTURE_DIR(8), GAMEPAD_GESTURE_DIR(9),
+		GAMEPAD_GESTURE_PRESS(BUTTON_A), GAMEPAD_GESTURE_PRESS(BUTTON_B), GAMEPAD_GESTURE_PRESS(BUTTON_X),
+		GAMEPAD_GESTURE_PRESS(BUTTON_Y), GAMEPAD_GESTURE_RELEASE(BUTTON_A), GAMEPAD_GESTURE_HOLD(BUTTON_B),
+	};
+	const int KINDS = sizeof(SYMBOLS) / sizeof(SYMBOLS[0]);
+	unsigned int seed = 12345;
+	auto random = [&seed] {
+		seed = seed * 1103515245u + 12345u;
+		return (seed >> 16) & 0x7fff;
+	};
+
+	std::printf("[" BENCH_LIBRARY "] gestures:");
+	for (int count : { 1, 8, 32 }) {
+		std::vector<int> handles;
+		for (int i = 0; i != count; ++i) {
+			std::string pattern;
+			int length = 3 + static_cast<int>(random() % 4);
+			for (int j = 0; j != length; ++j) {
+				pattern += TOKENS[random() % KINDS];
+				pattern += ' ';
+			}
+			handles.push_back(GamepadGestureAdd(pattern.c_str(), 500, 0));
+		}
+
+		unsigned int time = 0;
+		double ns = measure([&] {
+			GamepadGestureFeed(GAMEPAD_0, SYMBOLS[random() % KINDS], time += 16);
+		});
+		std::printf(" %d patterns %.1f ns/symbol%s", count, ns, count != 32 ? "," : "\n");
+
+		for (int handle : handles) {
+			GamepadGestureRemove(handle);
+		}
+	}
+}
+
+/* Cost per motion sample through a pipe standing in for the sensor node */
+static void benchMotion() {
+#if defined(__linux__)
+	static const unsigned int SAMPLES = 256 * 1000;
+	static const unsigned int BATCH = 256;		/* a quarter second at 1 kHz */
+	int fds[2];
+
+	if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0 || !GamepadMotionAttach(GAMEPAD_3, fds[0])) {
+		std::printf("[" BENCH_LIBRARY "] motion: not available\n");
+		return;
+	}
+
+	/* a resting sensor with a gyro bias of 100 units, stamped at 1 kHz */
+	std::vector<input_event> events;
+	auto add = [&events](unsigned short type, unsigned short code, int value) {
+		input_event ev;
+		std::memset(&ev, 0, sizeof(ev));
+		ev.type = type;
+		ev.code = code;
+		ev.value = value;
+		events.push_back(ev);
+	};
+	for (unsigned int n = 0; n != BATCH; ++n) {
+		add(EV_ABS, ABS_X, 0);
+		add(EV_ABS, ABS_Y, 0);
+		add(EV_ABS, ABS_Z, 8192);
+		add(EV_ABS, ABS_RX, 100);
+		add(EV_ABS, ABS_RY, 100);
+		add(EV_ABS, ABS_RZ, 100);
+		add(EV_MSC, MSC_TIMESTAMP, 0);
+		add(EV_SYN, SYN_REPORT, 0);
+	}
+
+	GamepadMotionCalibrate(GAMEPAD_3, BATCH * 4);
+
+	std::vector<GAMEPAD_MOTION> samples(BATCH);
+	unsigned int read = 0, stamp = 0, badDt = 0;
+	float angles[3] = { 0.0f, 0.0f, 0.0f };
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int sent = 0; sent != SAMPLES; sent += BATCH) {
+		for (unsigned int n = 0; n != BATCH; ++n) {
+			events[n * 8 + 6].value = static_cast<int>(stamp += 1000);
+		}
+		if (write(fds[1], events.data(), events.size() * sizeof(input_event)) != static_cast<ssize_t>(events.size() * sizeof(input_event))) {
+			break;
+		}
+		bool calibrating = GamepadMotionCalibrating(GAMEPAD_3) != GAMEPAD_FALSE;
+		GamepadUpdate();
+
+		unsigned int got = GamepadMotionRead(GAMEPAD_3, samples.data(), BATCH);
+		for (unsigned int i = 0; i != got; ++i) {
+			badDt += read + i != 0 && samples[i].dt != 0.001f;
+		}
+		if (!calibrating) {
+			GamepadMotionIntegrate(samples.data(), got, angles);
+		}
+		read += got;
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	std::printf("[" BENCH_LIBRARY "] motion: %u of %u samples read, %u dropped, %u bad dt, "
+		"%.1f ns/sample, drift after calibration %.6f rad\n",
+		read, SAMPLES, GamepadMotionDropped(GAMEPAD_3), badDt,
+		std::chrono::duration<double, std::nano>(end - start).count() / SAMPLES,
+		angles[0] + angles[1] + angles[2]);
+
+	GamepadMotionDetach(GAMEPAD_3);
+	close(fds[1]);
+#else
+	std::printf("[" BENCH_LIBRARY "] motion: not available\n");
+#endif
+}
+
+/* Size of the per-device state and cost of deriving stick and trigger values from it */
+static void benchState() {
+#if defined(BENCH_UNITY)
+	static const int INPUTS = 4096;
+	std::vector<int> values(INPUTS * 6);
+	unsigned int seed = 54321;
+	for (int& v : values) {
+		seed = seed * 1103515245u + 12345u;
+		v = static_cast<int>((seed >> 8) % 65535u) - 32767;
+	}
+
+	GAMEPAD_STATE* state = &STATE[GAMEPAD_0];
+	int n = 0;
+	double ns = measure([&] {
+		const int* v = &values[(n++ % INPUTS) * 6];
+		state->stick[STICK_LEFT].x = static_cast<short>(v[0]);
+		state->stick[STICK_LEFT].y = static_cast<short>(v[1]);
+		state->stick[STICK_RIGHT].x = static_cast<short>(v[2]);
+		state->stick[STICK_RIGHT].y = static_cast<short>(v[3]);
+		state->trigger[TRIGGER_LEFT].value = static_cast<unsigned char>(v[4] & 255);
+		state->trigger[TRIGGER_RIGHT].value = static_cast<unsigned char>(v[5] & 255);
+		GamepadUpdateStick(&state->stick[STICK_LEFT], GAMEPAD_DEADZONE_LEFT_STICK);
+		GamepadUpdateStick(&state->stick[STICK_RIGHT], GAMEPAD_DEADZONE_RIGHT_STICK);
+		GamepadUpdateTrigger(&state->trigger[TRIGGER_LEFT]);
+		GamepadUpdateTrigger(&state->trigger[TRIGGER_RIGHT]);
+		KEEP = state->stick[STICK_LEFT].dirCurrent + state->stick[STICK_RIGHT].dirCurrent +
+			state->trigger[TRIGGER_LEFT].pressedCurrent;
+	});
+
+	std::printf("[" BENCH_LIBRARY "] state: sticks and triggers %zu bytes per device, update %.1f ns/frame\n",
+		sizeof(state->stick) + sizeof(state->trigger), ns);
+#else
+	std::printf("[" BENCH_LIBRARY "] state: needs a unity build\n");
+#endif
+}
+
+/* Counter of this thread's L1 data cache read misses in user space, or -1 if the kernel won't give one */
+static int openL1Misses() {
+#if defined(__linux__)
+	perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HW_CACHE;
+	attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+	return -1;
+#endif
+}
+
+/*
+ * A frame of all four pads starting from a cold cache, as it is after the
+ * game has run: the writes decoding leaves behind, the derived values
+ * GamepadUpdate computes, and a few queries per pad.  Counts the L1 misses
+ * and time of the frame, less those of measuring an empty one.
+ */
+static void benchLayout() {
+#if defined(BENCH_UNITY)
+	static const int LAYOUT_FRAMES = 20000;
+	std::vector<unsigned char> evict(1 << 20);
+	unsigned int seed = 98765;
+	int fd = openL1Misses();
+
+	for (int d = 0; d != GAMEPAD_COUNT; ++d) {
+		STATE[d].flags = FLAG_CONNECTED;
+	}
+
+	double ns[2] = { 0.0, 0.0 };
+	unsigned long long misses[2] = { 0, 0 };
+	for (int pass = 0; pass != 2; ++pass) {
+		for (int frame = 0; frame != LAYOUT_FRAMES; ++frame) {
+			for (size_t i = 0; i < evict.size(); i += 64) {
+				evict[i] = static_cast<unsigned char>(evict[i] + 1);
+			}
+
+			unsigned long long count = 0;
+			if (fd != -1) {
+				ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+			auto start = std::chrono::steady_clock::now();
+			if (pass == 1) {
+				unsigned int r = 0;
+				for (int d = 0; d != GAMEPAD_COUNT; ++d) {
+					GAMEPAD_STATE* state = &STATE[d];
+					seed = seed * 1103515245u + 12345u;
+					state->stick[STICK_LEFT].x = static_cast<short>((seed >> 16) - 32768);
+					state->stick[STICK_LEFT].y = static_cast<short>((seed & 0xffff) - 32768);
+					state->trigger[TRIGGER_LEFT].value = static_cast<unsigned char>(seed >> 24);
+					state->time = static_cast<unsigned int>(frame);
+
+					state->bLast = state->bCurrent;
+					if ((state->flags & FLAG_CONNECTED) != 0) {
+						GamepadUpdateStick(&state->stick[STICK_LEFT], GAMEPAD_DEADZONE_LEFT_STICK);
+						GamepadUpdateStick(&state->stick[STICK_RIGHT], GAMEPAD_DEADZONE_RIGHT_STICK);
+						GamepadUpdateTrigger(&state->trigger[TRIGGER_LEFT]);
+						GamepadUpdateTrigger(&state->trigger[TRIGGER_RIGHT]);
+					}
+				}
+				for (int d = 0; d != GAMEPAD_COUNT; ++d) {
+					GAMEPAD_DEVICE device = static_cast<GAMEPAD_DEVICE>(d);
+					r += GamepadIsConnected(device);
+					r += GamepadButtonTriggered(device, BUTTON_A);
+					r += GamepadStickDir(device, STICK_LEFT);
+					r += GamepadTriggerLength(device, TRIGGER_LEFT) > 0.5f;
+				}
+				KEEP = r;
+			}
+			auto end = std::chrono::steady_clock::now();
+			if (fd != -1) {
+				ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+				if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+					count = 0;
+				}
+			}
+			misses[pass] += count;
+			ns[pass] += std::chrono::duration<double, std::nano>(end - start).count();
+		}
+	}
+
+	/* cache lines the frame's fields live in, which bounds its misses without a counter */
+	std::vector<size_t> lines;
+	for (int d = 0; d != GAMEPAD_COUNT; ++d) {
+		const GAMEPAD_STATE* state = &STATE[d];
+		const void* fields[] = { state->stick, state->trigger, &state->bLast, &state->bCurrent, &state->flags, &state->time };
+		const size_t sizes[] = { sizeof(state->stick), sizeof(state->trigger), sizeof(state->bLast),
+			sizeof(state->bCurrent), sizeof(state->flags), sizeof(state->time) };
+		for (int f = 0; f != 6; ++f) {
+			size_t at = reinterpret_cast<size_t>(fields[f]);
+			for (size_t line = at / 64; line <= (at + sizes[f] - 1) / 64; ++line) {
+				lines.push_back(line);
+			}
+		}
+	}
+	std::sort(lines.begin(), lines.end());
+	size_t touched = static_cast<size_t>(std::unique(lines.begin(), lines.end()) - lines.begin());
+
+	std::printf("[" BENCH_LIBRARY "] layout: state %zu bytes per device, %zu cache lines for %d pads, cold frame ",
+		sizeof(GAMEPAD_STATE), touched, GAMEPAD_COUNT);
+	if (fd != -1) {
+		std::printf("%.1f L1 misses, ", static_cast<double>(misses[1] - misses[0]) / LAYOUT_FRAMES);
+		close(fd);
+	}
+	std::printf("%.1f ns\n", (ns[1] - ns[0]) / LAYOUT_FRAMES);
+	for (int d = 0; d != GAMEPAD_COUNT; ++d) {
+		STATE[d].flags = 0;
+	}
+#else
+	std::printf("[" BENCH_LIBRARY "] layout: needs a unity build\n");
+#endif
+}
+
+#if defined(BENCH_UNITY) && defined(__linux__)
+/* Writes made to each pipe-backed pad, and the applied events matched to them in order */
+static std::vector<unsigned long long> FEED_WRITTEN[GAMEPAD_COUNT];
+static std::vector<unsigned int> FEED_DUE[GAMEPAD_COUNT];
+static size_t FEED_APPLIED[GAMEPAD_COUNT];
+static std::vector<long long> FEED_AGES;
+static unsigned int FEED_UPDATES = 0, FEED_LATE = 0;
+
+static void onFeedEvent(const GAMEPAD_EVENT* event, void*) {
+	size_t k = FEED_APPLIED[event->device]++;
+	if (k < FEED_WRITTEN[event->device].size()) {
+		FEED_AGES.push_back(static_cast<long long>(event->stamp - FEED_WRITTEN[event->device][k]));
+		FEED_LATE += FEED_UPDATES > FEED_DUE[event->device][k];
+	}
+}
+
+static void feedSpin(unsigned long long micros) {
+	unsigned long long until = GamepadClock() + micros;
+	while (GamepadClock() < until) {
+	}
+}
+#endif
+
+#if defined(BENCH_UNITY) && defined(__linux__)
+/* One pass of the device read benchmark, through the ring or through read() */
+static void benchUringPass(bool ring) {
+	static const int IDLE_FRAMES = 100000;
+	static const int BUSY_FRAMES = 20000;
+	static const int STALE_FRAMES = 2000;
+	int fds[GAMEPAD_COUNT][2];
+
+	GamepadUringShutdown();
+	if (ring) {
+		GamepadUringInit(-1);
+		if (!GamepadUringActive()) {
+			std::printf("[" BENCH_LIBRARY "] uring: ring not available\n");
+			return;
+		}
+	}
+
+	for (int d = 0; d != GAMEPAD_COUNT; ++d) {
+		FEED_WRITTEN[d].clear();
+		FEED_DUE[d].clear();
+		FEED_APPLIED[d] = 0;
+		if (pipe2(fds[d], O_NONBLOCK | O_CLOEXEC) != 0) {
+			std::printf("[" BENCH_LIBRARY "] uring: not available\n");
+			return;
+		}
+		NODE[d].fd = fds[d][0];
+		std::memcpy(NODE[d].axmap, DEFAULT_AXMAP, sizeof(DEFAULT_AXMAP));
+		NODE[d].axes = sizeof(DEFAULT_AXMAP);
+		GamepadMappingCompile(&NODE[d].map, NODE[d].guid, NODE[d].axmap, NODE[d].axes);
+		STATE[d].flags = FLAG_CONNECTED;
+		GamepadUringAttach(static_cast<GAMEPAD_DEVICE>(d), fds[d][0]);
+	}
+	FEED_AGES.clear();
+	FEED_UPDATES = FEED_LATE = 0;
+
+	js_event events[8];
+	std::memset(events, 0, sizeof(events));
+	for (int n = 0; n != 8; ++n) {
+		events[n].type = JS_EVENT_AXIS;
+		events[n].number = static_cast<unsigned char>(n % 2);
+		events[n].value = static_cast<short>(n * 1000);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (int n = 0; n != IDLE_FRAMES; ++n) {
+		GamepadUpdate();
+	}
+	auto end = std::chrono::steady_clock::now();
+	double idle = std::chrono::duration<double, std::nano>(end - start).count() / IDLE_FRAMES;
+
+	bool fed = true;
+	start = std::chrono::steady_clock::now();
+	for (int n = 0; n != BUSY_FRAMES && fed; ++n) {
+		for (int d = 0; d != GAMEPAD_COUNT; ++d) {
+			fed = fed && write(fds[d][1], events, sizeof(events)) == static_cast<ssize_t>(sizeof(events));
+		}
+		GamepadUpdate();
+	}
+	end = std::chrono::steady_clock::now();
+	double busy = std::chrono::duration<double, std::nano>(end - start).count() / BUSY_FRAMES;
+
+	int subscription = GamepadSubscribe(GAMEPAD_MASK_ALL, GAMEPAD_MASK(EVENT_AXIS), GAMEPAD_MASK(STICK_LEFT), 0, onFeedEvent, NULL);
+	size_t sent = 0;
+	for (int n = 0; n != STALE_FRAMES && fed; ++n) {
+		for (int half = 0; half != 2; ++half) {
+			for (int d = 0; d != GAMEPAD_COUNT; ++d) {
+				js_event je;
+				std::memset(&je, 0, sizeof(je));
+				je.time = static_cast<unsigned int>(GamepadClock() / 1000);
+				je.type = JS_EVENT_AXIS;
+				je.value = static_cast<short>((FEED_WRITTEN[d].size() & 1) != 0 ? 20000 : -20000);
+				FEED_WRITTEN[d].push_back(GamepadClock());
+				FEED_DUE[d].push_back(FEED_UPDATES);
+				fed = fed && write(fds[d][1], &je, sizeof(je)) == static_cast<ssize_t>(sizeof(je));
+				++sent;
+			}
+			feedSpin(50);
+		}
+		GamepadUpdate();
+		++FEED_UPDATES;
+	}
+	/* whatever is left over arrives in the next frame */
+	GamepadUpdate();
+	++FEED_UPDATES;
+	GamepadUnsubscribe(subscription);
+
+	std::sort(FEED_AGES.begin(), FEED_AGES.end());
+	auto pct = [](size_t p) { return FEED_AGES[(FEED_AGES.size() - 1) * p / 100]; };
+	std::printf("[" BENCH_LIBRARY "] uring: %-6s idle update %.0f ns, 8 events per pad %.0f ns; ",
+		ring ? "ring," : "read,", idle, busy);
+	if (FEED_AGES.size() == sent) {
+		std::printf("staleness p50 %lld us, p99 %lld us, max %lld us, %u of %zu events a frame late\n",
+			pct(50), pct(99), pct(100), FEED_LATE, sent);
+	} else {
+		std::printf("staleness: %zu of %zu events seen\n", FEED_AGES.size(), sent);
+	}
+
+	for (int d = 0; d != GAMEPAD_COUNT; ++d) {
+		GamepadUringDetach(static_cast<GAMEPAD_DEVICE>(d));
+		close(fds[d][0]);
+		close(fds[d][1]);
+		NODE[d].fd = -1;
+		STATE[d].flags = 0;
+	}
+}
+#endif
+
+/*
+ * Device reads with four pads fed through pipes: the cost of an idle update
+ * and of one with input, and how stale input is when it is applied.  Each
+ * staleness frame writes one event per pad, a second one 50 us later, after
+ * a posted read has completed with the first, and updates 50 us after that;
+ * an event that update doesn't apply is a frame late.  Busy updates include
+ * the writes feeding the pipes.
+ */
+static void benchUring() {
+#if defined(BENCH_UNITY) && defined(__linux__)
+	bool active = GamepadUringActive();
+	benchUringPass(false);
+	benchUringPass(true);
+
+	/* give the library back the ring it started with */
+	GamepadUringShutdown();
+	if (active) {
+		GamepadUringInit(MON != NULL ? udev_monitor_get_fd(MON) : -1);
+	}
+#else
+	std::printf("[" BENCH_LIBRARY "] uring: needs a unity build\n");
+#endif
+}
+
+struct BENCHMARK {
+	const char* name;
+	void (*run)();
+};
+
+static const BENCHMARK BENCHMARKS[] = {
+	{ "accessors", benchAccessors },
+	{ "state", benchState },
+	{ "layout", benchLayout },
+	{ "waveform", benchWaveform },
+	{ "gestures", benchGestures },
+	{ "motion", benchMotion },
+	{ "uring", benchUring },
+};
+
+int main(int argc, char** argv) {
+	GamepadInit();
+
+	for (const BENCHMARK& bench : BENCHMARKS) {
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; ++i) {
+			selected = selected || std::strcmp(argv[i], bench.name) == 0;
+		}
+		if (selected) {
+			bench.run();
+		}
+	}
+
+	GamepadShutdown();
+	return BENCH_FAILURES == 0 ? 0 : 1;
+}
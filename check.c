@@ -0,0 +1,576 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+/*
+ * Subsystem checks.  Run "check".
+ *
+ * The library is compiled in so each case can drive a subsystem directly,
+ * without devices, and compare what comes out with what it should be.
+ */
+
+#include "gamepad_all.c"
+
+#include <pthread.h>
+#include <sched.h>
+
+#define CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		fprintf(stderr, "check: "); \
+		fprintf(stderr, __VA_ARGS__); \
+		fprintf(stderr, "\n"); \
+		++CHECK_FAILURES; \
+	} \
+} while (0)
+
+static int CHECK_FAILURES = 0;
+
+/* ---- channels ---- */
+
+#if !defined(GAMEPAD_NO_CHANNELS)
+
+/* Producers of the threaded cases, and events each of them pushes */
+#define CHANNEL_PRODUCERS	4
+#define CHANNEL_EVENTS		50000
+
+typedef struct CHANNEL_RUN CHANNEL_RUN;
+struct CHANNEL_RUN {
+	GAMEPAD_CHANNEL* channel;
+	int producer;
+	unsigned int refused;
+};
+
+/* Producers that have pushed all their events */
+static volatile unsigned int CHANNEL_DONE = 0;
+
+static void ChannelEvent(GAMEPAD_EVENT* event, int producer, unsigned int index) {
+	memset(event, 0, sizeof(*event));
+	event->type = EVENT_BUTTON_DOWN;
+	event->input = producer;
+	event->value = (int)index;
+}
+
+static void* ChannelProducer(void* arg) {
+	CHANNEL_RUN* run = (CHANNEL_RUN*)arg;
+	GAMEPAD_EVENT event;
+	unsigned int i;
+
+	for (i = 0; i != CHANNEL_EVENTS; ++i) {
+		ChannelEvent(&event, run->producer, i);
+		if (!GamepadChannelPush(run->channel, &event)) {
+			++run->refused;
+		}
+		/* give the consumer a turn on machines with few cores */
+		if (i % 64 == 63) {
+			sched_yield();
+		}
+	}
+	ATOMIC_INC(&CHANNEL_DONE);
+	return NULL;
+}
+
+/* One thread fills a channel past its capacity, then drains it */
+static void caseChannelSerial(GAMEPAD_OVERFLOW overflow) {
+	GAMEPAD_CHANNEL* channel = GamepadChannelCreate(8, overflow, 0, 0, 0, 0);
+	GAMEPAD_EVENT event;
+	unsigned int i, accepted = 0, first = overflow == OVERFLOW_DROP_OLDEST ? 4 : 0;
+
+	for (i = 0; i != 12; ++i) {
+		ChannelEvent(&event, 0, i);
+		accepted += GamepadChannelPush(channel, &event) ? 1 : 0;
+	}
+	CHECK(accepted == (overflow == OVERFLOW_DROP_OLDEST ? 12u : 8u), "serial %d: %u pushes accepted", overflow, accepted);
+	CHECK(GamepadChannelDropped(channel) == 4, "serial %d: %u dropped, want 4", overflow, GamepadChannelDropped(channel));
+
+	for (i = 0; GamepadChannelPop(channel, &event); ++i) {
+		CHECK(event.value == (int)(first + i), "serial %d: popped %d at %u", overflow, event.value, i);
+	}
+	CHECK(i == 8, "serial %d: popped %u, want 8", overflow, i);
+	GamepadChannelDestroy(channel);
+}
+
+static void* ChannelPushOne(void* arg) {
+	CHANNEL_RUN* run = (CHANNEL_RUN*)arg;
+	GAMEPAD_EVENT event;
+
+	ChannelEvent(&event, 0, 8);
+	run->refused = GamepadChannelPush(run->channel, &event) ? 0 : 1;
+	ATOMIC_INC(&CHANNEL_DONE);
+	return NULL;
+}
+
+/*
+ * A full channel whose consumer has claimed the oldest cell but not finished
+ * copying it isn't full; a push has to wait for the copy, not drop events.
+ */
+static void caseChannelClaimed(void) {
+	GAMEPAD_CHANNEL* channel = GamepadChannelCreate(8, OVERFLOW_DROP_OLDEST, 0, 0, 0, 0);
+	GAMEPAD_EVENT event;
+	CHANNEL_RUN run;
+	pthread_t thread;
+	unsigned int i, pos;
+
+	for (i = 0; i != 8; ++i) {
+		ChannelEvent(&event, 0, i);
+		GamepadChannelPush(channel, &event);
+	}
+
+	/* the first half of GamepadChannelTake */
+	pos = channel->tail;
+	ATOMIC_CAS(&channel->tail, pos, pos + 1);
+
+	CHANNEL_DONE = 0;
+	run.channel = channel;
+	run.refused = 0;
+	pthread_create(&thread, NULL, ChannelPushOne, &run);
+	usleep(20000);
+	CHECK(ATOMIC_LOAD(&CHANNEL_DONE) == 0, "claimed: push finished while the oldest cell was being copied");
+	CHECK(GamepadChannelDropped(channel) == 0, "claimed: %u dropped while the consumer was copying", GamepadChannelDropped(channel));
+
+	/* and the second half */
+	ATOMIC_STORE(&channel->cells[pos & channel->mask].sequence, pos + channel->mask + 1);
+	pthread_join(thread, NULL);
+
+	CHECK(run.refused == 0 && GamepadChannelDropped(channel) == 0, "claimed: push refused or dropped after the copy");
+	for (i = 1; GamepadChannelPop(channel, &event); ++i) {
+		CHECK(event.value == (int)i, "claimed: popped %d, want %u", event.value, i);
+	}
+	CHECK(i == 9, "claimed: popped %u, want 8", i - 1);
+	GamepadChannelDestroy(channel);
+}
+
+/*
+ * Producers race a consumer through a small channel.  Each producer's events
+ * must come out in order, and every event is either popped or counted as
+ * dropped exactly once.
+ */
+static void caseChannelThreaded(GAMEPAD_OVERFLOW overflow) {
+	CHANNEL_RUN runs[CHANNEL_PRODUCERS];
+	pthread_t threads[CHANNEL_PRODUCERS];
+	GAMEPAD_CHANNEL* channel = GamepadChannelCreate(16, overflow, 0, 0, 0, 0);
+	GAMEPAD_EVENT event;
+	int next[CHANNEL_PRODUCERS];
+	unsigned int popped = 0, refused = 0, misordered = 0, dropped;
+	int i, done;
+
+	CHANNEL_DONE = 0;
+	for (i = 0; i != CHANNEL_PRODUCERS; ++i) {
+		runs[i].channel = channel;
+		runs[i].producer = i;
+		runs[i].refused = 0;
+		next[i] = 0;
+		pthread_create(&threads[i], NULL, ChannelProducer, &runs[i]);
+	}
+
+	/* pop until the producers are finished and the channel is empty */
+	for (;;) {
+		done = ATOMIC_LOAD(&CHANNEL_DONE) == CHANNEL_PRODUCERS;
+		if (!GamepadChannelPop(channel, &event)) {
+			if (done) {
+				break;
+			}
+			continue;
+		}
+		if (event.input < 0 || event.input >= CHANNEL_PRODUCERS || event.value < next[event.input]) {
+			++misordered;
+		} else {
+			next[event.input] = event.value + 1;
+		}
+		/* stall now and then so the producers overrun the channel */
+		if (++popped % 256 == 0) {
+			sched_yield();
+		}
+	}
+	for (i = 0; i != CHANNEL_PRODUCERS; ++i) {
+		pthread_join(threads[i], NULL);
+		refused += runs[i].refused;
+	}
+
+	dropped = GamepadChannelDropped(channel);
+	CHECK(misordered == 0, "threaded %d: %u events out of order", overflow, misordered);
+	CHECK(popped + dropped == CHANNEL_PRODUCERS * CHANNEL_EVENTS,
+		"threaded %d: %u popped + %u dropped, want %u", overflow, popped, dropped, CHANNEL_PRODUCERS * CHANNEL_EVENTS);
+	CHECK(overflow == OVERFLOW_DROP_OLDEST ? refused == 0 : refused == dropped,
+		"threaded %d: %u pushes refused, %u dropped", overflow, refused, dropped);
+	GamepadChannelDestroy(channel);
+}
+
+#endif
+
+/* ---- mappings ---- */
+
+#if defined(__linux__) && !defined(GAMEPAD_NO_MAPPING_DB)
+
+/* Device the mapping cases compile for: bus 3, vendor 1234, product 5678, version 1 */
+#define MAPPING_GUID "03000000341200007856000001000000"
+
+static const unsigned short CHECK_GUID[4] = { 3, 0x1234, 0x5678, 1 };
+
+/* Two sticks and a hat, as joydev would number them */
+static const unsigned char CHECK_AXMAP[] = { ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_HAT0X, ABS_HAT0Y };
+
+/* Compile a mapping line, feed one joystick axis value and return the state */
+static GAMEPAD_STATE MappingFeed(const char* controls, int axis, int value) {
+	GAMEPAD_MAPPING map;
+	GAMEPAD_STATE state;
+	char line[512];
+
+	snprintf(line, sizeof(line), MAPPING_GUID ",Check Pad,%splatform:Linux,", controls);
+	CHECK(GamepadAddMapping(line) >= 0, "mapping: \"%s\" did not parse", controls);
+	GamepadMappingCompile(&map, CHECK_GUID, CHECK_AXMAP, sizeof(CHECK_AXMAP));
+
+	memset(&state, 0, sizeof(state));
+	GamepadMappingAxis(&state, &map, axis, value);
+	return state;
+}
+
+#define MAPPING_X(controls, axis, value)		(MappingFeed(controls, axis, value).stick[STICK_LEFT].x)
+#define MAPPING_Y(controls, axis, value)		(MappingFeed(controls, axis, value).stick[STICK_LEFT].y)
+
+/* Each half of an output keeps its own source */
+static void caseMappingHalves(void) {
+	static const char* const SPLIT = "+leftx:+a0,-leftx:-a0,";
+	static const char* const SPLIT_Y = "+lefty:+a1,-lefty:-a1,";
+	static const char* const HAT = "+leftx:h0.2,-leftx:h0.8,";
+
+	CHECK(MAPPING_X(SPLIT, 0, 20000) == 20000, "halves: +a0 gave %d", MAPPING_X(SPLIT, 0, 20000));
+	CHECK(MAPPING_X(SPLIT, 0, -20000) == -20000, "halves: -a0 gave %d", MAPPING_X(SPLIT, 0, -20000));
+	CHECK(MAPPING_X(SPLIT, 0, 0) == 0, "halves: centred a0 gave %d", MAPPING_X(SPLIT, 0, 0));
+
+	/* the same as "lefty:a1", whose Y points up */
+	CHECK(MAPPING_Y(SPLIT_Y, 1, -20000) == 20000, "halves: -a1 gave y %d", MAPPING_Y(SPLIT_Y, 1, -20000));
+	CHECK(MAPPING_Y(SPLIT_Y, 1, 20000) == -20000, "halves: +a1 gave y %d", MAPPING_Y(SPLIT_Y, 1, 20000));
+
+	/* the hat is joystick axis 4 */
+	CHECK(MAPPING_X(HAT, 4, 32767) == 32767, "halves: hat right gave %d", MAPPING_X(HAT, 4, 32767));
+	CHECK(MAPPING_X(HAT, 4, -32767) == -32767, "halves: hat left gave %d", MAPPING_X(HAT, 4, -32767));
+	CHECK(MAPPING_X(HAT, 4, 0) == 0, "halves: hat centred gave %d", MAPPING_X(HAT, 4, 0));
+}
+
+/* Half an axis is stretched over a whole output, but not over half of one */
+static void caseMappingStretch(void) {
+	CHECK(MAPPING_X("-leftx:-a0,", 0, 0) == 0, "stretch: centred half output gave %d", MAPPING_X("-leftx:-a0,", 0, 0));
+	CHECK(MAPPING_X("-leftx:-a0,", 0, -32767) == -32767, "stretch: full half output gave %d", MAPPING_X("-leftx:-a0,", 0, -32767));
+	CHECK(MAPPING_X("+leftx:+a0,", 0, 16000) == 16000, "stretch: half output gave %d", MAPPING_X("+leftx:+a0,", 0, 16000));
+
+	CHECK(MAPPING_X("leftx:+a0,", 0, 0) == -32767, "stretch: released half source gave %d", MAPPING_X("leftx:+a0,", 0, 0));
+	CHECK(MAPPING_X("leftx:+a0,", 0, 32767) == 32767, "stretch: pressed half source gave %d", MAPPING_X("leftx:+a0,", 0, 32767));
+	CHECK(MAPPING_X("leftx:a0~,", 0, 1000) == -1000, "stretch: inverted axis gave %d", MAPPING_X("leftx:a0~,", 0, 1000));
+}
+
+/* A whole file is parsed, with comments and other platforms skipped */
+static void caseMappingFile(void) {
+	char path[] = "/tmp/gamepad-check-XXXXXX";
+	GAMEPAD_MAPPING map;
+	GAMEPAD_STATE state;
+	unsigned short other[4] = { 3, 0x1234, 0x9abc, 2 };
+	FILE* file;
+	int fd;
+
+	fd = mkstemp(path);
+	file = fdopen(fd, "w");
+	fputs("# comment\n"
+		"\n"
+		"0300000034120000bc9a000000000000,File Pad,a:b3,leftx:a1,platform:Linux,\n"
+		"0300000034120000bc9a000000000000,File Pad,a:b4,platform:Windows,\n"
+		"03000000341200007856000001000000,Check Pad,a:b0,leftx:a0,platform:Linux,\n", file);
+	fclose(file);
+
+	/* Check Pad is already known from the cases above, so only File Pad is new */
+	CHECK(GamepadAddMappingsFromFile(path) == 1, "file: wrong count of new mappings");
+	unlink(path);
+
+	/* an unknown version falls back to the entry without one */
+	GamepadMappingCompile(&map, other, CHECK_AXMAP, sizeof(CHECK_AXMAP));
+	memset(&state, 0, sizeof(state));
+	GamepadMappingButton(&state, &map, 3, 1);
+	GamepadMappingAxis(&state, &map, 1, 1234);
+	CHECK(state.bCurrent == BUTTON_TO_FLAG(BUTTON_A), "file: b3 gave buttons %x", state.bCurrent);
+	CHECK(state.stick[STICK_LEFT].x == 1234, "file: a1 gave x %d", state.stick[STICK_LEFT].x);
+}
+
+#endif
+
+/* ---- gestures ---- */
+
+#if !defined(GAMEPAD_NO_GESTURES)
+
+#define GESTURE_SEEN	16
+
+/* Gestures delivered, as handle and time */
+static int GESTURE_HANDLE[GESTURE_SEEN];
+static unsigned int GESTURE_TIME[GESTURE_SEEN];
+static int GESTURE_COUNT_SEEN = 0;
+
+static void GestureSeen(const GAMEPAD_EVENT* event, void* user) {
+	if (GESTURE_COUNT_SEEN != GESTURE_SEEN) {
+		GESTURE_HANDLE[GESTURE_COUNT_SEEN] = event->input;
+		GESTURE_TIME[GESTURE_COUNT_SEEN] = event->time;
+	}
+	++GESTURE_COUNT_SEEN;
+}
+
+/* Feed symbols and check which gestures completed, in order */
+static void GestureExpect(const char* name, const int* symbols, const unsigned int* times, int count,
+		const int* handles, int expected) {
+	int i;
+
+	GESTURE_COUNT_SEEN = 0;
+	for (i = 0; i != count; ++i) {
+		GamepadGestureFeed(GAMEPAD_0, symbols[i], times[i]);
+	}
+	CHECK(GESTURE_COUNT_SEEN == expected, "%s: %d gestures, want %d", name, GESTURE_COUNT_SEEN, expected);
+	for (i = 0; i != expected && i != GESTURE_COUNT_SEEN; ++i) {
+		CHECK(GESTURE_HANDLE[i] == handles[i], "%s: gesture %d is %d, want %d", name, i, GESTURE_HANDLE[i], handles[i]);
+	}
+}
+
+static void GestureClear(const int* handles, int count) {
+	int i;
+	for (i = 0; i != count; ++i) {
+		GamepadGestureRemove(handles[i]);
+	}
+	GamepadGestureReset(GAMEPAD_0);
+}
+
+#define PRESS(b)	GAMEPAD_GESTURE_PRESS(BUTTON_##b)
+#define RELEASE(b)	GAMEPAD_GESTURE_RELEASE(BUTTON_##b)
+#define DIR(d)		GAMEPAD_GESTURE_DIR(d)
+#define COUNT(a)	((int)(sizeof(a) / sizeof((a)[0])))
+
+/* Symbols one pattern doesn't use don't break it, whatever other patterns use */
+static void caseGestureAlphabets(void) {
+	int handles[3];
+	handles[0] = GamepadGestureAdd("a a", 0, 0);
+	handles[1] = GamepadGestureAdd("-a b", 0, 0);
+	handles[2] = GamepadGestureAdd("2 3 6 a", 0, 0);
+
+	{
+		/* a release and a stick wobble between the taps */
+		static const int symbols[] = { PRESS(A), RELEASE(A), DIR(6), DIR(5), PRESS(A) };
+		static const unsigned int times[] = { 0, 10, 15, 18, 20 };
+		GestureExpect("double tap", symbols, times, COUNT(symbols), handles, 1);
+	}
+	{
+		static const int symbols[] = { RELEASE(A), PRESS(B) };
+		static const unsigned int times[] = { 30, 40 };
+		GestureExpect("release then b", symbols, times, COUNT(symbols), &handles[1], 1);
+	}
+	{
+		/* b is no press "a a" cares about, so the a closes a second double tap */
+		static const int symbols[] = { DIR(2), DIR(3), DIR(6), PRESS(A) };
+		static const unsigned int times[] = { 50, 60, 70, 80 };
+		static const int expected[] = { 0, 2 };
+		GestureExpect("quarter circle", symbols, times, COUNT(symbols), expected, 2);
+	}
+	{
+		/* a direction the quarter circle uses, out of turn, does break it */
+		static const int symbols[] = { RELEASE(A), DIR(2), DIR(3), DIR(2), DIR(6), PRESS(A) };
+		static const unsigned int times[] = { 90, 100, 110, 120, 130, 140 };
+		GestureExpect("broken circle", symbols, times, COUNT(symbols), handles, 1);
+	}
+
+	GestureClear(handles, COUNT(handles));
+}
+
+/* Windows bound the whole gesture, gaps each step of it */
+static void caseGestureTiming(void) {
+	int handles[2];
+	handles[0] = GamepadGestureAdd("a a", 300, 0);
+	handles[1] = GamepadGestureAdd("2 3 6 a", 0, 100);
+
+	{
+		static const int symbols[] = { PRESS(A), PRESS(A), PRESS(A) };
+		static const unsigned int times[] = { 1000, 1400, 1600 };
+		GestureExpect("window", symbols, times, COUNT(symbols), handles, 1);
+	}
+	{
+		static const int symbols[] = { DIR(2), DIR(3), DIR(6), PRESS(A) };
+		static const unsigned int times[] = { 2000, 2050, 2300, 2350 };
+		GestureExpect("gap", symbols, times, COUNT(symbols), handles, 0);
+	}
+	{
+		static const int symbols[] = { DIR(2), DIR(3), DIR(6), PRESS(A) };
+		static const unsigned int times[] = { 3000, 3050, 3100, 3150 };
+		GestureExpect("in time", symbols, times, COUNT(symbols), &handles[1], 1);
+	}
+
+	GestureClear(handles, COUNT(handles));
+}
+
+/* A hold completes on the clock, dated by the press plus the hold time */
+static void caseGestureHold(void) {
+	int handles[1];
+	handles[0] = GamepadGestureAdd("[b]", 0, 0);
+	GamepadGestureHoldTime(100);
+
+	GESTURE_COUNT_SEEN = 0;
+	GamepadGestureInput(GAMEPAD_0, BUTTON_TO_FLAG(BUTTON_B), 0, 0, 5000);
+	GamepadGestureTick(GAMEPAD_0, GamepadTimeMicros() + 50000);
+	CHECK(GESTURE_COUNT_SEEN == 0, "hold: completed early");
+	GamepadGestureTick(GAMEPAD_0, GamepadTimeMicros() + 150000);
+	CHECK(GESTURE_COUNT_SEEN == 1 && GESTURE_HANDLE[0] == handles[0] && GESTURE_TIME[0] == 5100,
+		"hold: %d gestures, want one at 5100", GESTURE_COUNT_SEEN);
+	GamepadGestureTick(GAMEPAD_0, GamepadTimeMicros() + 300000);
+	CHECK(GESTURE_COUNT_SEEN == 1, "hold: completed twice");
+
+	GamepadGestureInput(GAMEPAD_0, 0, 0, 0, 5200);
+	GamepadGestureHoldTime(500);
+	GestureClear(handles, COUNT(handles));
+}
+
+#endif
+
+/* ---- rumble ---- */
+
+#define RUMBLE_SEEN	16
+
+/* Time the rumble cases count from, in microseconds */
+#define RUMBLE_EPOCH	1000000000ull
+
+/* Levels written to the first device, strong then weak */
+static unsigned short RUMBLE_WRITES[RUMBLE_SEEN][2];
+static int RUMBLE_COUNT_SEEN = 0;
+
+static GAMEPAD_BOOL RumbleSeen(GAMEPAD_DEVICE device, unsigned short strong, unsigned short weak, void* user) {
+	if (device != GAMEPAD_0) {
+		return GAMEPAD_TRUE;
+	}
+	if (RUMBLE_COUNT_SEEN != RUMBLE_SEEN) {
+		RUMBLE_WRITES[RUMBLE_COUNT_SEEN][0] = strong;
+		RUMBLE_WRITES[RUMBLE_COUNT_SEEN][1] = weak;
+	}
+	++RUMBLE_COUNT_SEEN;
+	return GAMEPAD_TRUE;
+}
+
+/* A constant effect, to be shaped further by the caller */
+static GAMEPAD_RUMBLE RumbleEffect(float left, float right, int priority) {
+	GAMEPAD_RUMBLE effect;
+
+	memset(&effect, 0, sizeof(effect));
+	effect.left = left;
+	effect.right = right;
+	effect.priority = priority;
+	return effect;
+}
+
+/* Play an effect on the first device, starting a number of milliseconds into the case */
+static int RumblePlayAt(unsigned int at, const GAMEPAD_RUMBLE* effect) {
+	int handle = GamepadRumblePlay(GAMEPAD_0, effect);
+
+	/* pinned, rather than taken from the clock, so the envelope is exact */
+	RUMBLE[GAMEPAD_0].source[RUMBLE_HANDLE_SOURCE(handle)].start = RUMBLE_EPOCH + at * 1000ull;
+	return handle;
+}
+
+/* Mix a number of milliseconds into the case and check the single write it makes */
+static void RumbleExpect(const char* name, unsigned int at, unsigned short strong, unsigned short weak) {
+	RUMBLE_COUNT_SEEN = 0;
+	GamepadRumbleUpdate(RUMBLE_EPOCH + at * 1000ull);
+	CHECK(RUMBLE_COUNT_SEEN == 1, "%s: %d writes, want 1", name, RUMBLE_COUNT_SEEN);
+	CHECK(RUMBLE_COUNT_SEEN == 0 || (RUMBLE_WRITES[0][0] == strong && RUMBLE_WRITES[0][1] == weak),
+		"%s: wrote %u %u, want %u %u", name, RUMBLE_WRITES[0][0], RUMBLE_WRITES[0][1], strong, weak);
+}
+
+/* Mix a number of milliseconds into the case and check nothing is written */
+static void RumbleUnchanged(const char* name, unsigned int at) {
+	RUMBLE_COUNT_SEEN = 0;
+	GamepadRumbleUpdate(RUMBLE_EPOCH + at * 1000ull);
+	CHECK(RUMBLE_COUNT_SEEN == 0, "%s: %d writes, want none", name, RUMBLE_COUNT_SEEN);
+}
+
+/* Equal priorities add up, higher ones mute them, envelopes shape them */
+static void caseRumbleMix(void) {
+	GAMEPAD_RUMBLE effect;
+	int low, other, high, top, under;
+
+	GamepadSetRumbleSink(RumbleSeen, NULL);
+
+	/* nothing has been written yet, so even silence goes out once */
+	effect = RumbleEffect(0.25f, 0.5f, 0);
+	low = RumblePlayAt(10, &effect);
+	RumbleExpect("before start", 0, 0, 0);
+	RumbleUnchanged("still silent", 5);
+	RumbleExpect("started", 10, 16384, 32768);
+	RumbleUnchanged("steady", 15);
+
+	effect = RumbleEffect(0.5f, 0.25f, 0);
+	other = RumblePlayAt(20, &effect);
+	RumbleExpect("equal priority", 20, 49151, 49151);
+	RumbleUnchanged("equal steady", 25);
+
+	/* a higher priority mutes the others even while its attack starts from nothing */
+	effect = RumbleEffect(1.0f, 0.0f, 1);
+	effect.duration = 400;
+	effect.attack = 100;
+	effect.fade = 100;
+	high = RumblePlayAt(100, &effect);
+	RumbleExpect("attack start", 100, 0, 0);
+	RumbleExpect("attack half", 150, 32768, 0);
+	RumbleExpect("attack done", 200, 65535, 0);
+	RumbleUnchanged("sustain", 300);
+	RumbleExpect("fade half", 450, 32768, 0);
+	RumbleExpect("ended", 500, 49151, 49151);
+
+	/* the ended effect's slot is reused, and its old handle no longer reaches it */
+	effect = RumbleEffect(0.0f, 1.0f, 2);
+	top = RumblePlayAt(510, &effect);
+	CHECK(RUMBLE_HANDLE_SOURCE(top) == RUMBLE_HANDLE_SOURCE(high) && top != high,
+		"generation: handle %d reused as %d", high, top);
+	GamepadRumbleStop(high);
+	RumbleExpect("stale stop", 510, 0, 65535);
+
+	/* mixed after the higher priority, and still muted by it */
+	effect = RumbleEffect(0.25f, 0.25f, 0);
+	under = RumblePlayAt(515, &effect);
+	RumbleUnchanged("muted", 515);
+
+	GamepadRumbleStop(top);
+	RumbleExpect("stop", 520, 65535, 65535);
+	GamepadRumbleStop(top);
+	RumbleUnchanged("stop twice", 530);
+
+	GamepadRumbleStop(low);
+	RumbleExpect("stop low", 540, 49151, 32768);
+	GamepadRumbleStop(other);
+	RumbleExpect("stop other", 550, 16384, 16384);
+	GamepadRumbleStop(under);
+	RumbleExpect("stop under", 560, 0, 0);
+	RumbleUnchanged("silent", 570);
+
+	GamepadRumbleStopAll(GAMEPAD_0);
+	GamepadSetRumbleSink(NULL, NULL);
+}
+
+int main(void) {
+#if !defined(GAMEPAD_NO_CHANNELS)
+	caseChannelSerial(OVERFLOW_DROP_NEWEST);
+	caseChannelSerial(OVERFLOW_DROP_OLDEST);
+	caseChannelClaimed();
+	caseChannelThreaded(OVERFLOW_DROP_NEWEST);
+	caseChannelThreaded(OVERFLOW_DROP_OLDEST);
+#endif
+
+#if !defined(GAMEPAD_NO_GESTURES)
+	GamepadSubscribe(GAMEPAD_MASK(GAMEPAD_0), GAMEPAD_MASK(EVENT_GESTURE), ~0u, 0, GestureSeen, NULL);
+	caseGestureAlphabets();
+	caseGestureTiming();
+	caseGestureHold();
+#endif
+
+#if defined(__linux__) && !defined(GAMEPAD_NO_MAPPING_DB)
+	caseMappingHalves();
+	caseMappingStretch();
+	caseMappingFile();
+	GamepadMappingShutdown();
+#endif
+
+	caseRumbleMix();
+
+	printf("%s: %d failures\n", CHECK_FAILURES == 0 ? "ok" : "FAILED", CHECK_FAILURES);
+	return CHECK_FAILURES == 0 ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+/*
+ * Coroutine scheduler checks.  Run "coro".
+ *
+ * The library is compiled in so button events can be emitted without a
+ * device.  Each case suspends a few coroutines, emits an event, and checks
+ * which of them gamepad::update() resumed; the interesting ones have a
+ * resumed coroutine destroy others that are waiting.  Build it with
+ * -fsanitize=address to catch a scheduler that touches a destroyed waiter.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "gamepad_all.c"
+#include "gamepad_coro.hpp"
+
+#define CORO_CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		std::fprintf(stderr, "coro: "); \
+		std::fprintf(stderr, __VA_ARGS__); \
+		std::fprintf(stderr, "\n"); \
+		++CORO_FAILURES; \
+	} \
+} while (0)
+
+static int CORO_FAILURES = 0;
+
+/* A coroutine that keeps its frame after finishing, so the case can destroy it */
+struct task {
+	struct promise_type {
+		task get_return_object() {
+			return task{ std::coroutine_handle<promise_type>::from_promise(*this) };
+		}
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() {}
+	};
+
+	std::coroutine_handle<promise_type> handle;
+};
+
+/* What each coroutine of a case did */
+static std::vector<int> RESUMED;
+static std::vector<task> TASKS;
+
+static void press(GAMEPAD_DEVICE device, GAMEPAD_BUTTON button) {
+	GamepadEmitButtons(device, 0, BUTTON_TO_FLAG(button), 0);
+}
+
+static void reset() {
+	for (task& t : TASKS) {
+		if (t.handle) {
+			t.handle.destroy();
+		}
+	}
+	TASKS.clear();
+	RESUMED.clear();
+}
+
+static void destroy(size_t index) {
+	TASKS[index].handle.destroy();
+	TASKS[index].handle = nullptr;
+}
+
+/* Wait for A, then destroy the given coroutines */
+static task killer(int id, std::vector<size_t> victims) {
+	co_await gamepad::nextButton(GAMEPAD_0, BUTTON_A);
+	RESUMED.push_back(id);
+	for (size_t v : victims) {
+		destroy(v);
+	}
+}
+
+/* Wait for a button, then for another press of it */
+static task waiter(int id, GAMEPAD_BUTTON button) {
+	co_await gamepad::nextButton(GAMEPAD_0, button);
+	RESUMED.push_back(id);
+	co_await gamepad::nextButton(GAMEPAD_0, button);
+	RESUMED.push_back(id + 100);
+}
+
+/* Waiters resume in the order they started waiting */
+static void caseOrder() {
+	TASKS.push_back(waiter(0, BUTTON_A));
+	TASKS.push_back(waiter(1, BUTTON_A));
+	TASKS.push_back(waiter(2, BUTTON_B));
+	press(GAMEPAD_0, BUTTON_A);
+	gamepad::update();
+	CORO_CHECK(RESUMED == std::vector<int>({ 0, 1 }), "order: %zu resumed for A", RESUMED.size());
+	press(GAMEPAD_0, BUTTON_B);
+	gamepad::update();
+	CORO_CHECK(RESUMED == std::vector<int>({ 0, 1, 2 }), "order: %zu resumed after B", RESUMED.size());
+	reset();
+}
+
+/* A resumed coroutine destroys a sibling later in the same batch; the one after still runs */
+static void caseSiblingReady() {
+	TASKS.push_back(killer(0, { 1 }));
+	TASKS.push_back(waiter(1, BUTTON_A));
+	TASKS.push_back(waiter(2, BUTTON_A));
+	press(GAMEPAD_0, BUTTON_A);
+	gamepad::update();
+	CORO_CHECK(RESUMED == std::vector<int>({ 0, 2 }), "sibling: expected 0 and 2 resumed, got %zu", RESUMED.size());
+
+	/* the survivor still gets its next event */
+	press(GAMEPAD_0, BUTTON_A);
+	gamepad::update();
+	CORO_CHECK(RESUMED.size() == 3 && RESUMED[2] == 102, "sibling: survivor missed its second press");
+	reset();
+}
+
+/* A resumed coroutine destroys every other one in the batch */
+static void caseSiblingsAll() {
+	TASKS.push_back(killer(0, { 1, 2, 3 }));
+	TASKS.push_back(waiter(1, BUTTON_A));
+	TASKS.push_back(waiter(2, BUTTON_A));
+	TASKS.push_back(waiter(3, BUTTON_A));
+	press(GAMEPAD_0, BUTTON_A);
+	gamepad::update();
+	CORO_CHECK(RESUMED == std::vector<int>({ 0 }), "all: %zu resumed", RESUMED.size());
+	reset();
+}
+
+/* A resumed coroutine destroys one still waiting for a different event */
+static void caseSiblingPending() {
+	TASKS.push_back(killer(0, { 1 }));
+	TASKS.push_back(waiter(1, BUTTON_B));
+	press(GAMEPAD_0, BUTTON_A);
+	gamepad::update();
+	press(GAMEPAD_0, BUTTON_B);
+	gamepad::update();
+	CORO_CHECK(RESUMED == std::vector<int>({ 0 }), "pending: %zu resumed", RESUMED.size());
+	reset();
+}
+
+int main() {
+	GamepadInit();
+
+	caseOrder();
+	caseSiblingReady();
+	caseSiblingsAll();
+	caseSiblingPending();
+
+	GamepadShutdown();
+	std::printf("%s: %d failures\n", CORO_FAILURES == 0 ? "ok" : "FAILED", CORO_FAILURES);
+	return CORO_FAILURES == 0 ? 0 : 1;
+}
@@ -6,12 +6,13 @@
  */
 
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <malloc.h>
 
 #define GAMEPAD_EXPORT 1
-#include "gamepad.h"
+#include "gamepad_private.h"
 
 /* Platform-specific includes */
 #if defined(_WIN32)
@@ -23,58 +24,23 @@
 #elif defined(__linux__)
 #	include <linux/joystick.h>
 #	include <stdio.h>
+#	include <time.h>
 #	include <fcntl.h>
 #	include <unistd.h>
+#	include <sys/epoll.h>
 #	include <libudev.h>
 #else
 #	error "Unknown platform in gamepad.c"
 #endif
 
-#define BUTTON_TO_FLAG(b) (1 << (b))
-
-/* Axis information */
-typedef struct GAMEPAD_AXIS GAMEPAD_AXIS;
-struct GAMEPAD_AXIS {
-	int x, y;
-	float nx, ny;
-	float length;
-	float angle;
-	GAMEPAD_STICKDIR dirLast, dirCurrent;
-};
-
-/* Trigger value information */
-typedef struct GAMEPAD_TRIGINFO GAMEPAD_TRIGINFO;
-struct GAMEPAD_TRIGINFO {
-	int value;
-	float length;
-	GAMEPAD_BOOL pressedLast, pressedCurrent;
-};
-
-/* Structure for state of a particular gamepad */
-typedef struct GAMEPAD_STATE GAMEPAD_STATE;
-struct GAMEPAD_STATE {
-	GAMEPAD_AXIS stick[STICK_COUNT];
-	GAMEPAD_TRIGINFO trigger[TRIGGER_COUNT];
-	int bLast, bCurrent, flags;
-#if defined(__linux__)
-	char* device;
-	int fd;
-	int effect;
-#endif
-};
-
-/* State of the four gamepads */
-static GAMEPAD_STATE STATE[4];
-
-/* Note whether a gamepad is currently connected */
-#define FLAG_CONNECTED	(1<<0)
-#define FLAG_RUMBLE		(1<<1)
+/* Per-frame state of the four gamepads, one aligned block each */
+static GAMEPAD_STATE STATE[GAMEPAD_COUNT];
 
 /* Prototypes for utility functions */
 static void GamepadResetState		(GAMEPAD_DEVICE gamepad);
 static void GamepadUpdateCommon		(void);
 static void GamepadUpdateDevice		(GAMEPAD_DEVICE gamepad);
-static void GamepadUpdateStick		(GAMEPAD_AXIS* axis, float deadzone);
+static void GamepadUpdateStick		(GAMEPAD_AXIS* axis, int deadzone);
 static void GamepadUpdateTrigger	(GAMEPAD_TRIGINFO* trig);
 
 /* Various values of PI */
@@ -86,6 +52,9 @@ static void GamepadUpdateTrigger	(GAMEPAD_TRIGINFO* trig);
 /* Platform-specific implementation code */
 #if defined(_WIN32)
 
+/* Packet number of each device's last applied state */
+static DWORD PACKET[GAMEPAD_COUNT];
+
 void GamepadInit(void) {
 	int i;
 	for (i = 0; i != GAMEPAD_COUNT; ++i) {
@@ -97,17 +66,59 @@ void GamepadUpdate(void) {
 	GamepadUpdateCommon();
 }
 
+GAMEPAD_BOOL GamepadWait(int timeout) {
+	static DWORD packets[GAMEPAD_COUNT];
+	DWORD start = GetTickCount();
+	XINPUT_STATE xs;
+	int i;
+
+	/* XInput can't be waited on, so poll packet numbers */
+	for (;;) {
+		for (i = 0; i != GAMEPAD_COUNT; ++i) {
+			DWORD packet = XInputGetState(i, &xs) == 0 ? xs.dwPacketNumber : 0;
+			if (packet != packets[i]) {
+				packets[i] = packet;
+				return GAMEPAD_TRUE;
+			}
+		}
+		if (timeout >= 0 && GetTickCount() - start >= (DWORD)timeout) {
+			return GAMEPAD_FALSE;
+		}
+		Sleep(1);
+	}
+}
+
 static void GamepadUpdateDevice(GAMEPAD_DEVICE gamepad) {
 	XINPUT_STATE xs;
 	if (XInputGetState(gamepad, &xs) == 0) {
+		int before = STATE[gamepad].bCurrent;
+		unsigned long long received;
+
+		/* nothing new since the last poll */
+		if ((STATE[gamepad].flags & FLAG_CONNECTED) != 0 && xs.dwPacketNumber == PACKET[gamepad]) {
+			return;
+		}
+		PACKET[gamepad] = xs.dwPacketNumber;
+
+		STATE[gamepad].time = GetTickCount();
+
 		/* reset if the device was not already connected */
 		if ((STATE[gamepad].flags & FLAG_CONNECTED) == 0) {
 			GamepadResetState(gamepad);
+			GamepadRumbleReset(gamepad);
+			GamepadGestureReset(gamepad);
+			GamepadLatencyReset(gamepad);
+			before = 0;
+			GamepadEmitEvent(gamepad, EVENT_CONNECTED, 0, 0, STATE[gamepad].time);
 		}
 
 		/* mark that we are connected w/ rumble support */
 		STATE[gamepad].flags |= FLAG_CONNECTED|FLAG_RUMBLE;
 
+		/* a new packet is an input; its tick count is the closest thing to a kernel stamp */
+		received = GamepadTimeMicros();
+		GamepadLatencyInput(gamepad, STATE[gamepad].time, received, received);
+
 		/* update state */
 		STATE[gamepad].bCurrent = xs.Gamepad.wButtons;
 		STATE[gamepad].trigger[TRIGGER_LEFT].value = xs.Gamepad.bLeftTrigger;
@@ -116,91 +127,419 @@ static void GamepadUpdateDevice(GAMEPAD_DEVICE gamepad) {
 		STATE[gamepad].stick[STICK_LEFT].y = xs.Gamepad.sThumbLY;
 		STATE[gamepad].stick[STICK_RIGHT].x = xs.Gamepad.sThumbRX;
 		STATE[gamepad].stick[STICK_RIGHT].y = xs.Gamepad.sThumbRY;
-	} else {
+
+		/* XInput is polled, so edges are found by comparing snapshots */
+		GamepadEmitButtons(gamepad, before, STATE[gamepad].bCurrent, STATE[gamepad].time);
+		GamepadEmitAxis(gamepad, STICK_LEFT, xs.Gamepad.sThumbLX, xs.Gamepad.sThumbLY, STATE[gamepad].time);
+		GamepadEmitAxis(gamepad, STICK_RIGHT, xs.Gamepad.sThumbRX, xs.Gamepad.sThumbRY, STATE[gamepad].time);
+		if (GamepadGesturesActive()) {
+			GamepadGestureInput(gamepad, STATE[gamepad].bCurrent, xs.Gamepad.sThumbLX, xs.Gamepad.sThumbLY, STATE[gamepad].time);
+		}
+	} else if ((STATE[gamepad].flags & FLAG_CONNECTED) != 0) {
 		/* disconnected */
 		STATE[gamepad].flags &= ~FLAG_CONNECTED;
+		GamepadEmitEvent(gamepad, EVENT_DISCONNECTED, 0, 0, GetTickCount());
 	}
 }
 
 void GamepadShutdown(void) {
-	/* no Win32 shutdown required */
+	GamepadRumbleShutdown();
+	GamepadMappingShutdown();
+}
+
+unsigned long long GamepadTimeMicros(void) {
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (unsigned long long)(counter.QuadPart / frequency.QuadPart) * 1000000 +
+		(unsigned long long)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+}
+
+GAMEPAD_BOOL GamepadIsRestored(GAMEPAD_DEVICE device) {
+	/* XInput owns slot assignment */
+	return GAMEPAD_FALSE;
+}
+
+unsigned int GamepadAttachTime(GAMEPAD_DEVICE device) {
+	return 0;
 }
 
-void GamepadSetRumble(GAMEPAD_DEVICE gamepad, float left, float right) {
-	if ((STATE[gamepad].flags & FLAG_RUMBLE) != 0) {
-		XINPUT_VIBRATION vib;
-		ZeroMemory(&vib, sizeof(vib));
-		vib.wLeftMotorSpeed = (WORD)(left * 65535);
-		vib.wRightMotorSpeed = (WORD)(right * 65535);
-		XInputSetState(gamepad, &vib);
+GAMEPAD_BOOL GamepadRumbleOutput(GAMEPAD_DEVICE gamepad, unsigned short strong, unsigned short weak) {
+	XINPUT_VIBRATION vib;
+
+	if ((STATE[gamepad].flags & FLAG_RUMBLE) == 0) {
+		return GAMEPAD_FALSE;
 	}
+
+	ZeroMemory(&vib, sizeof(vib));
+	vib.wLeftMotorSpeed = strong;
+	vib.wRightMotorSpeed = weak;
+	return XInputSetState(gamepad, &vib) == ERROR_SUCCESS ? GAMEPAD_TRUE : GAMEPAD_FALSE;
 }
 
 #elif defined(__linux__)
 
+/* Device nodes of the four gamepads; only touched on hotplug, reads and rumble */
+static GAMEPAD_NODE NODE[GAMEPAD_COUNT];
+
 /* UDev handles */
 static struct udev* UDEV = NULL;
 static struct udev_monitor* MON = NULL;
 
-static void GamepadAddDevice(const char* devPath);
-static void GamepadRemoveDevice(const char* devPath);
+/* Readiness of every device and the monitor, for GamepadWait */
+static int EPOLL = -1;
 
-/* Helper to add a new device */
-static void GamepadAddDevice(const char* devPath) {
+/* Joystick events read per system call */
+#define JS_BATCH	64
+
+/* Axis layout assumed when the driver can't report one (xpad) */
+static const unsigned char DEFAULT_AXMAP[] = {
+	ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_RY, ABS_RZ, ABS_HAT0X, ABS_HAT0Y
+};
+
+static void GamepadAddDevice(struct udev_device* dev, unsigned long long received);
+static void GamepadRemoveDevice(struct udev_device* dev);
+static void GamepadDecodeEvent(GAMEPAD_DEVICE gamepad, const struct js_event* je, unsigned long long received, unsigned long long applied);
+
+unsigned long long GamepadTimeMicros(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Read the bus/vendor/product/version of the input device behind a joystick node */
+static void GamepadReadGUID(struct udev_device* parent, unsigned short guid[4]) {
+	static const char* ATTRS[4] = { "id/bustype", "id/vendor", "id/product", "id/version" };
+	const char* value;
 	int i;
 
-	/* try to find a free controller */
+	for (i = 0; i != 4; ++i) {
+		value = parent != NULL ? udev_device_get_sysattr_value(parent, ATTRS[i]) : NULL;
+		guid[i] = value != NULL ? (unsigned short)strtoul(value, NULL, 16) : 0;
+	}
+}
+
+/*
+ * Build a stable identity for a device: the unique id (serial or Bluetooth
+ * address) if the driver reports one, otherwise the physical path.  Devices
+ * with neither get an empty identity and are never restored.
+ */
+static void GamepadReadIdentity(struct udev_device* parent, const unsigned short guid[4], char* identity) {
+	const char* id = NULL;
+
+	identity[0] = '\0';
+	if (parent == NULL) {
+		return;
+	}
+
+	id = udev_device_get_sysattr_value(parent, "uniq");
+	if (id == NULL || id[0] == '\0') {
+		id = udev_device_get_sysattr_value(parent, "phys");
+	}
+	if (id != NULL && id[0] != '\0') {
+		snprintf(identity, GAMEPAD_IDENTITY_SIZE, "%04x:%04x:%s", guid[1], guid[2], id);
+	}
+}
+
+/* Query the axis layout and calibration and build the device's mapping table */
+static void GamepadProbeDevice(GAMEPAD_DEVICE gamepad) {
+	GAMEPAD_NODE* node = &NODE[gamepad];
+	unsigned char axes = 0;
+
+	if (ioctl(node->fd, JSIOCGAXES, &axes) != -1 && ioctl(node->fd, JSIOCGAXMAP, node->axmap) != -1) {
+		node->axes = axes;
+	} else {
+		memcpy(node->axmap, DEFAULT_AXMAP, sizeof(DEFAULT_AXMAP));
+		node->axes = sizeof(DEFAULT_AXMAP);
+	}
+
+	/* the driver fills one correction per axis */
+	node->hasCorr = (node->axes <= MAPPING_MAX_AXES &&
+			ioctl(node->fd, JSIOCGCORR, node->corr) != -1) ? GAMEPAD_TRUE : GAMEPAD_FALSE;
+
+	GamepadMappingCompile(&node->map, node->guid, node->axmap, node->axes);
+}
+
+/* Rebuild the mapping tables of known devices after the database changed */
+void GamepadRefreshMappings(void) {
+	int i;
 	for (i = 0; i != GAMEPAD_COUNT; ++i) {
-		if ((STATE[i].flags & FLAG_CONNECTED) == 0) {
+		if ((STATE[i].flags & FLAG_CONNECTED) != 0 || NODE[i].identity[0] != '\0') {
+			GamepadMappingCompile(&NODE[i].map, NODE[i].guid, NODE[i].axmap, NODE[i].axes);
+		}
+	}
+}
+
+/* Add a descriptor to the wait set; closing it removes it again */
+void GamepadWatchFd(int fd) {
+	struct epoll_event ev;
+	if (EPOLL != -1) {
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.fd = fd;
+		epoll_ctl(EPOLL, EPOLL_CTL_ADD, fd, &ev);
+	}
+}
+
+/* Open the event node of a joystick's input device if it can rumble */
+static int GamepadOpenRumble(struct udev_device* parent) {
+	unsigned long bits[FF_MAX / (8 * sizeof(long)) + 1];
+	struct udev_enumerate* enu;
+	struct udev_list_entry* item;
+	int fd = -1;
+
+	if (parent == NULL) {
+		return -1;
+	}
+
+	enu = udev_enumerate_new(UDEV);
+	udev_enumerate_add_match_parent(enu, parent);
+	udev_enumerate_add_match_sysname(enu, "event*");
+	udev_enumerate_scan_devices(enu);
+
+	udev_list_entry_foreach(item, udev_enumerate_get_list_entry(enu)) {
+		struct udev_device* dev = udev_device_new_from_syspath(UDEV, udev_list_entry_get_name(item));
+		const char* devPath = dev != NULL ? udev_device_get_devnode(dev) : NULL;
+
+		if (devPath != NULL) {
+			fd = open(devPath, O_RDWR|O_NONBLOCK|O_CLOEXEC);
+		}
+		if (dev != NULL) {
+			udev_device_unref(dev);
+		}
+		if (fd != -1) {
 			break;
 		}
 	}
-	if (i == GAMEPAD_COUNT) {
+	udev_enumerate_unref(enu);
+
+	/* only keep it if the driver does rumble effects */
+	memset(bits, 0, sizeof(bits));
+	if (fd != -1 && (ioctl(fd, EVIOCGBIT(EV_FF, sizeof(bits)), bits) == -1 ||
+			(bits[FF_RUMBLE / (8 * sizeof(long))] & (1ul << (FF_RUMBLE % (8 * sizeof(long))))) == 0)) {
+		close(fd);
+		fd = -1;
+	}
+
+	return fd;
+}
+
+#if !defined(GAMEPAD_NO_MOTION)
+/*
+ * Motion sensors are a separate input device next to the joystick (hid-sony,
+ * hid-playstation, hid-nintendo).  They report the same identity, which is how
+ * a sensor node finds its pad.
+ */
+static void GamepadAddMotion(struct udev_device* dev) {
+	const char* devPath = udev_device_get_devnode(dev);
+	const char* accel = udev_device_get_property_value(dev, "ID_INPUT_ACCELEROMETER");
+	const char* sysName = udev_device_get_sysname(dev);
+	struct udev_device* parent;
+	unsigned short guid[4];
+	char identity[GAMEPAD_IDENTITY_SIZE];
+	int i, fd;
+
+	if (devPath == NULL || accel == NULL || strcmp(accel, "1") != 0 ||
+			sysName == NULL || strncmp(sysName, "event", 5) != 0) {
 		return;
 	}
 
-	/* copy the device path */
-	STATE[i].device = strdup(devPath);
-	if (STATE[i].device == NULL) {
+	parent = udev_device_get_parent_with_subsystem_devtype(dev, "input", NULL);
+	GamepadReadGUID(parent, guid);
+	GamepadReadIdentity(parent, guid, identity);
+	if (identity[0] == '\0') {
 		return;
 	}
 
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		if ((STATE[i].flags & FLAG_CONNECTED) != 0 && !GamepadHasMotion((GAMEPAD_DEVICE)i) &&
+				strcmp(NODE[i].identity, identity) == 0) {
+			fd = open(devPath, O_RDONLY|O_NONBLOCK|O_CLOEXEC);
+			if (fd != -1 && !GamepadMotionAttach((GAMEPAD_DEVICE)i, fd)) {
+				close(fd);
+			}
+			break;
+		}
+	}
+}
+
+/* Pair connected pads with sensor nodes that appeared before them */
+static void GamepadFindMotion(void) {
+	struct udev_enumerate* enu;
+	struct udev_list_entry* item;
+
+	enu = udev_enumerate_new(UDEV);
+	udev_enumerate_add_match_subsystem(enu, "input");
+	udev_enumerate_add_match_property(enu, "ID_INPUT_ACCELEROMETER", "1");
+	udev_enumerate_add_match_sysname(enu, "event*");
+	udev_enumerate_scan_devices(enu);
+
+	udev_list_entry_foreach(item, udev_enumerate_get_list_entry(enu)) {
+		struct udev_device* dev = udev_device_new_from_syspath(UDEV, udev_list_entry_get_name(item));
+		if (dev != NULL) {
+			GamepadAddMotion(dev);
+			udev_device_unref(dev);
+		}
+	}
+	udev_enumerate_unref(enu);
+}
+#else
+#	define GamepadAddMotion(dev)	((void)0)
+#	define GamepadFindMotion()		((void)0)
+#endif
+
+/* Close a slot, keeping what we learned about the device for a reconnect */
+static void GamepadCloseDevice(GAMEPAD_DEVICE gamepad) {
+	if ((STATE[gamepad].flags & FLAG_CONNECTED) != 0) {
+		GamepadEmitEvent(gamepad, EVENT_DISCONNECTED, 0, 0, STATE[gamepad].time);
+	}
+	if (NODE[gamepad].fd != -1) {
+		GamepadUringDetach(gamepad);
+		close(NODE[gamepad].fd);
+		NODE[gamepad].fd = -1;
+	}
+	GamepadMotionDetach(gamepad);
+	/* closing the event node also erases the effects uploaded through it */
+	GamepadRumbleLock();
+	if (NODE[gamepad].ffd != -1) {
+		close(NODE[gamepad].ffd);
+		NODE[gamepad].ffd = -1;
+	}
+	NODE[gamepad].effect = -1;
+	NODE[gamepad].rumbling = GAMEPAD_FALSE;
+	STATE[gamepad].flags = 0;
+	GamepadRumbleUnlock();
+	NODE[gamepad].devnum = 0;
+	NODE[gamepad].removed = GamepadTimeMicros();
+}
+
+/*
+ * Pick a slot for a device: the slot it had before if we know it, then a slot
+ * that has never been claimed, then the slot that has been free the longest.
+ */
+static int GamepadFindSlot(const char* identity, const unsigned short guid[4]) {
+	int i, slot = -1;
+
+	if (identity[0] != '\0') {
+		for (i = 0; i != GAMEPAD_COUNT; ++i) {
+			if (strcmp(NODE[i].identity, identity) == 0 && memcmp(NODE[i].guid, guid, sizeof(NODE[i].guid)) == 0) {
+				return i;
+			}
+		}
+	}
+
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		if ((STATE[i].flags & FLAG_CONNECTED) == 0) {
+			if (NODE[i].identity[0] == '\0') {
+				return i;
+			}
+			if (slot == -1 || NODE[i].removed < NODE[slot].removed) {
+				slot = i;
+			}
+		}
+	}
+
+	return slot;
+}
+
+/* Helper to add a new device */
+static void GamepadAddDevice(struct udev_device* dev, unsigned long long received) {
+	const char* devPath = udev_device_get_devnode(dev);
+	struct udev_device* parent;
+	unsigned short guid[4];
+	char identity[GAMEPAD_IDENTITY_SIZE];
+	GAMEPAD_BOOL restored, first;
+	struct js_event je;
+	unsigned long long now;
+	int i;
+
+	parent = udev_device_get_parent_with_subsystem_devtype(dev, "input", NULL);
+	GamepadReadGUID(parent, guid);
+	GamepadReadIdentity(parent, guid, identity);
+
+	/* try to find a free controller */
+	i = GamepadFindSlot(identity, guid);
+	if (i == -1) {
+		return;
+	}
+
+	/* a flaky link can announce the new node before removing the old one */
+	if ((STATE[i].flags & FLAG_CONNECTED) != 0) {
+		GamepadCloseDevice((GAMEPAD_DEVICE)i);
+	}
+	restored = (identity[0] != '\0' && strcmp(NODE[i].identity, identity) == 0) ? GAMEPAD_TRUE : GAMEPAD_FALSE;
+
 	/* reset device state */
-	GamepadResetState(i);
+	GamepadResetState((GAMEPAD_DEVICE)i);
 
-	/* attempt to open the device in read-write mode, which we need fo rumble */
-	STATE[i].fd = open(STATE[i].device, O_RDWR|O_NONBLOCK);
-	if (STATE[i].fd != -1) {
-		STATE[i].flags = FLAG_CONNECTED|FLAG_RUMBLE;
+	/* the joystick node is only read; rumble needs the event node */
+	NODE[i].fd = open(devPath, O_RDONLY|O_NONBLOCK);
+	if (NODE[i].fd == -1) {
 		return;
 	}
 
-	/* attempt to open in read-only mode if access was denied */
-	if (errno == EACCES) {
-		STATE[i].fd = open(STATE[i].device, O_RDONLY|O_NONBLOCK);
-		if (STATE[i].fd != -1) {
-			STATE[i].flags = FLAG_CONNECTED;
-			return;
+	/* waveform threads may be writing to this slot */
+	GamepadRumbleLock();
+	STATE[i].flags = FLAG_CONNECTED;
+	NODE[i].ffd = GamepadOpenRumble(parent);
+	if (NODE[i].ffd != -1) {
+		STATE[i].flags |= FLAG_RUMBLE;
+	}
+	GamepadRumbleUnlock();
+	GamepadRumbleReset((GAMEPAD_DEVICE)i);
+	GamepadGestureReset((GAMEPAD_DEVICE)i);
+	GamepadLatencyReset((GAMEPAD_DEVICE)i);
+
+	NODE[i].devnum = udev_device_get_devnum(dev);
+	if (!GamepadUringAttach((GAMEPAD_DEVICE)i, NODE[i].fd)) {
+		GamepadWatchFd(NODE[i].fd);
+	}
+
+	/* a known device gets its cached layout, mapping and calibration back */
+	if (restored) {
+		if (NODE[i].hasCorr) {
+			ioctl(NODE[i].fd, JSIOCSCORR, NODE[i].corr);
 		}
+	} else {
+		memcpy(NODE[i].guid, guid, sizeof(guid));
+		memcpy(NODE[i].identity, identity, sizeof(identity));
+		GamepadProbeDevice((GAMEPAD_DEVICE)i);
 	}
 
-	/* could not open the device at all */
-	free(STATE[i].device);
-	STATE[i].device = NULL;
+	NODE[i].restored = restored;
+	NODE[i].attachTime = GamepadTimeMicros() - received;
+
+	/* the sensor node may have been announced first */
+	GamepadFindMotion();
+
+	/* joydev stamps its startup events as they are read, so the first one dates the connection */
+	first = read(NODE[i].fd, &je, sizeof(je)) == (ssize_t)sizeof(je) ? GAMEPAD_TRUE : GAMEPAD_FALSE;
+	if (first) {
+		STATE[i].time = je.time;
+	}
+	GamepadEmitEvent((GAMEPAD_DEVICE)i, EVENT_CONNECTED, 0, 0, STATE[i].time);
+	if (first) {
+		now = GamepadTimeMicros();
+		GamepadDecodeEvent((GAMEPAD_DEVICE)i, &je, now, now);
+		GamepadLatencyDone((GAMEPAD_DEVICE)i);
+	}
+}
+
+GAMEPAD_BOOL GamepadIsRestored(GAMEPAD_DEVICE device) {
+	return (STATE[device].flags & FLAG_CONNECTED) != 0 ? NODE[device].restored : GAMEPAD_FALSE;
+}
+
+unsigned int GamepadAttachTime(GAMEPAD_DEVICE device) {
+	return (unsigned int)NODE[device].attachTime;
 }
 
 /* Helper to remove a device */
-static void GamepadRemoveDevice(const char* devPath) {
+static void GamepadRemoveDevice(struct udev_device* dev) {
+	dev_t devnum = udev_device_get_devnum(dev);
 	int i;
 	for (i = 0; i != GAMEPAD_COUNT; ++i) {
-		if (STATE[i].device != NULL && strcmp(STATE[i].device, devPath) == 0) {
-			if (STATE[i].fd != -1) {
-				close(STATE[i].fd);
-				STATE[i].fd = -1;
-			}
-			free(STATE[i].device);
-			STATE[i].device = 0;
-			STATE[i].flags = 0;
+		if ((STATE[i].flags & FLAG_CONNECTED) != 0 && NODE[i].devnum == devnum) {
+			GamepadCloseDevice((GAMEPAD_DEVICE)i);
 			break;
 		}
 	}
@@ -215,9 +554,12 @@ void GamepadInit(void) {
 	/* initialize connection state */
 	for (i = 0; i != GAMEPAD_COUNT; ++i) {
 		STATE[i].flags = 0;
-		STATE[i].fd = STATE[i].effect = -1;
+		NODE[i].fd = NODE[i].ffd = NODE[i].effect = -1;
+		NODE[i].identity[0] = '\0';
 	}
 
+	EPOLL = epoll_create1(EPOLL_CLOEXEC);
+
 	/* open the udev handle */
 	UDEV = udev_new();
 	if (UDEV == NULL) {
@@ -231,8 +573,12 @@ void GamepadInit(void) {
 	if (MON != NULL) {
 		udev_monitor_enable_receiving(MON);
 		udev_monitor_filter_add_match_subsystem_devtype(MON, "input", NULL);
+		GamepadWatchFd(udev_monitor_get_fd(MON));
 	}
 
+	/* keep reads posted in a ring if the kernel lets us; otherwise read each update */
+	GamepadUringInit(MON != NULL ? udev_monitor_get_fd(MON) : -1);
+
 	/* enumerate joypad devices */
 	enu = udev_enumerate_new(UDEV);
 	udev_enumerate_add_match_subsystem(enu, "input");
@@ -251,7 +597,7 @@ void GamepadInit(void) {
 		devPath = udev_device_get_devnode(dev);
 
 		if (sysPath != NULL && devPath != NULL && strstr(sysPath, "/js") != 0) {
-			GamepadAddDevice(devPath);
+			GamepadAddDevice(dev, GamepadTimeMicros());
 		}
 
 		udev_device_unref(dev);
@@ -261,8 +607,49 @@ void GamepadInit(void) {
 	udev_enumerate_unref(enu);
 }
 
+GAMEPAD_BOOL GamepadWait(int timeout) {
+	struct epoll_event ev;
+	if (EPOLL == -1) {
+		return GAMEPAD_FALSE;
+	}
+	return epoll_wait(EPOLL, &ev, 1, timeout) > 0 ? GAMEPAD_TRUE : GAMEPAD_FALSE;
+}
+
+/* Handle one device change from the monitor; GAMEPAD_FALSE if there was none */
+static GAMEPAD_BOOL GamepadReceiveDevice(void) {
+	unsigned long long received = GamepadTimeMicros();
+	struct udev_device* dev = udev_monitor_receive_device(MON);
+	if (dev) {
+		const char* sysPath = udev_device_get_syspath(dev);
+		const char* action = udev_device_get_action(dev);
+		sysPath = udev_device_get_syspath(dev);
+		action = udev_device_get_action(dev);
+
+		if (strstr(sysPath, "/js") != 0) {
+			if (strcmp(action, "remove") == 0) {
+				GamepadRemoveDevice(dev);
+			} else if (strcmp(action, "add") == 0) {
+				GamepadAddDevice(dev, received);
+			}
+		} else if (strcmp(action, "add") == 0) {
+			/* a sensor that goes away is noticed when reading it fails */
+			GamepadAddMotion(dev);
+		}
+
+		udev_device_unref(dev);
+		return GAMEPAD_TRUE;
+	}
+	return GAMEPAD_FALSE;
+}
+
 void GamepadUpdate(void) {
-	if (MON != NULL) {
+	if (GamepadUringActive()) {
+		/* the ring has been polling all along; the monitor poll says if udev has news */
+		if (GamepadUringReap()) {
+			while (GamepadReceiveDevice()) {
+			}
+		}
+	} else if (MON != NULL) {
 		fd_set r;
 		struct timeval tv;
 		int fd = udev_monitor_get_fd(MON);
@@ -276,99 +663,83 @@ void GamepadUpdate(void) {
 
 		select(fd + 1, &r, 0, 0, &tv);
 
-		/* test if we have a device change */
+		/* take every pending change; a flaky cable can queue several per frame */
 		if (FD_ISSET(fd, &r)) {
-			struct udev_device* dev = udev_monitor_receive_device(MON);
-			if (dev) {
-				const char* devNode = udev_device_get_devnode(dev);
-				const char* sysPath = udev_device_get_syspath(dev);
-				const char* action = udev_device_get_action(dev);
-				sysPath = udev_device_get_syspath(dev);
-				action = udev_device_get_action(dev);
-
-				if (strstr(sysPath, "/js") != 0) {
-					if (strcmp(action, "remove") == 0) {
-						GamepadRemoveDevice(devNode);
-					} else if (strcmp(action, "add") == 0) {
-						GamepadAddDevice(devNode);
-					}
-				}
-
-				udev_device_unref(dev);
+			while (GamepadReceiveDevice()) {
 			}
 		}
 	}
 
 	GamepadUpdateCommon();
+
+	/* arm the polls that fired in one system call */
+	GamepadUringSubmit();
 }
 
-static void GamepadUpdateDevice(GAMEPAD_DEVICE gamepad) {
-	if (STATE[gamepad].flags & FLAG_CONNECTED) {
-		struct js_event je;
-		while (read(STATE[gamepad].fd, &je, sizeof(je)) > 0) {
-			int button;
-			switch (je.type) {
-			case JS_EVENT_BUTTON:
-				/* determine which button the event is for */
-				switch (je.number) {
-				case 0: button = BUTTON_A; break;
-				case 1: button = BUTTON_B; break;
-				case 2: button = BUTTON_X; break;
-				case 3: button = BUTTON_Y; break;
-				case 4: button = BUTTON_LEFT_SHOULDER; break;
-				case 5: button = BUTTON_RIGHT_SHOULDER; break;
-				case 6: button = BUTTON_BACK; break;
-				case 7: button = BUTTON_START; break;
-				case 8: button = 0; break; /* XBOX button  */
-				case 9: button = BUTTON_LEFT_THUMB; break;
-				case 10: button = BUTTON_RIGHT_THUMB; break;
-				default: button = 0; break;
-				}
+/* Apply a joystick event and notify subscribers of what changed */
+static void GamepadDecodeEvent(GAMEPAD_DEVICE gamepad, const struct js_event* je, unsigned long long received, unsigned long long applied) {
+	GAMEPAD_STATE* state = &STATE[gamepad];
+	int before = state->bCurrent;
+	int i;
 
-				/* set or unset the button */
-				if (je.value) {
-					STATE[gamepad].bCurrent |= BUTTON_TO_FLAG(button);
-				} else {
-					STATE[gamepad].bCurrent ^= BUTTON_TO_FLAG(button);
-				}
-					
-				break;
-			case JS_EVENT_AXIS:
-				/* normalize and store the axis */
-				switch (je.number) {
-				case 0:	STATE[gamepad].stick[STICK_LEFT].x = je.value; break;
-				case 1:	STATE[gamepad].stick[STICK_LEFT].y = -je.value; break;
-				case 2:	STATE[gamepad].trigger[TRIGGER_LEFT].value = (je.value + 32768) >> 8; break;
-				case 3:	STATE[gamepad].stick[STICK_RIGHT].x = je.value; break;
-				case 4:	STATE[gamepad].stick[STICK_RIGHT].y = -je.value; break;
-				case 5:	STATE[gamepad].trigger[TRIGGER_RIGHT].value = (je.value + 32768) >> 8; break;
-				case 6:
-					if (je.value == -32767) {
-						STATE[gamepad].bCurrent |= BUTTON_TO_FLAG(BUTTON_DPAD_LEFT);
-						STATE[gamepad].bCurrent &= ~BUTTON_TO_FLAG(BUTTON_DPAD_RIGHT);
-					} else if (je.value == 32767) {
-						STATE[gamepad].bCurrent |= BUTTON_TO_FLAG(BUTTON_DPAD_RIGHT);
-						STATE[gamepad].bCurrent &= ~BUTTON_TO_FLAG(BUTTON_DPAD_LEFT);
-					} else {
-						STATE[gamepad].bCurrent &= ~BUTTON_TO_FLAG(BUTTON_DPAD_LEFT) & ~BUTTON_TO_FLAG(BUTTON_DPAD_RIGHT);
-					}
-					break;
-				case 7:
-					if (je.value == -32767) {
-						STATE[gamepad].bCurrent |= BUTTON_TO_FLAG(BUTTON_DPAD_UP);
-						STATE[gamepad].bCurrent &= ~BUTTON_TO_FLAG(BUTTON_DPAD_DOWN);
-					} else if (je.value == 32767) {
-						STATE[gamepad].bCurrent |= BUTTON_TO_FLAG(BUTTON_DPAD_DOWN);
-						STATE[gamepad].bCurrent &= ~BUTTON_TO_FLAG(BUTTON_DPAD_UP);
-					} else {
-						STATE[gamepad].bCurrent &= ~BUTTON_TO_FLAG(BUTTON_DPAD_UP) & ~BUTTON_TO_FLAG(BUTTON_DPAD_DOWN);
-					}
-					break;
-				default: break;
+	state->time = je->time;
+	GamepadLatencyInput(gamepad, je->time, received, applied);
+
+	/* initial state events are applied like any other */
+	switch (je->type & ~JS_EVENT_INIT) {
+	case JS_EVENT_BUTTON:
+		GamepadMappingButton(state, &NODE[gamepad].map, je->number, je->value);
+		break;
+	case JS_EVENT_AXIS:
+		if (GamepadWantsEvent(gamepad, EVENT_AXIS)) {
+			int x[STICK_COUNT], y[STICK_COUNT];
+			for (i = 0; i != STICK_COUNT; ++i) {
+				x[i] = state->stick[i].x;
+				y[i] = state->stick[i].y;
+			}
+			GamepadMappingAxis(state, &NODE[gamepad].map, je->number, je->value);
+			for (i = 0; i != STICK_COUNT; ++i) {
+				if (x[i] != state->stick[i].x || y[i] != state->stick[i].y) {
+					GamepadEmitAxis(gamepad, (GAMEPAD_STICK)i, state->stick[i].x, state->stick[i].y, je->time);
 				}
+			}
+		} else {
+			GamepadMappingAxis(state, &NODE[gamepad].map, je->number, je->value);
+		}
+		break;
+	default:
+		break;
+	}
 
-				break;
-			default:
+	/* hats and axes can drive buttons too */
+	if (state->bCurrent != before) {
+		GamepadEmitButtons(gamepad, before, state->bCurrent, je->time);
+	}
+
+	/* gestures see every event, not just the state at the next update */
+	if (GamepadGesturesActive()) {
+		GamepadGestureInput(gamepad, state->bCurrent, state->stick[STICK_LEFT].x, state->stick[STICK_LEFT].y, je->time);
+	}
+}
+
+static void GamepadUpdateDevice(GAMEPAD_DEVICE gamepad) {
+	/* with a ring, only a node whose poll fired has anything to read */
+	if ((STATE[gamepad].flags & FLAG_CONNECTED) != 0 && (!GamepadUringActive() || GamepadUringReadable(gamepad))) {
+		/* one clock read covers the batch; read and applied are the same moment here */
+		struct js_event events[JS_BATCH];
+		unsigned long long now = 0;
+		ssize_t got;
+		int i, count;
+		while ((got = read(NODE[gamepad].fd, events, sizeof(events))) > 0) {
+			if (now == 0) {
+				now = GamepadTimeMicros();
+			}
+			count = (int)(got / sizeof(events[0]));
+			for (i = 0; i != count; ++i) {
+				GamepadDecodeEvent(gamepad, &events[i], now, now);
+			}
+			/* a short read emptied the node */
+			if (count != JS_BATCH) {
 				break;
 			}
 		}
@@ -382,60 +753,78 @@ void GamepadShutdown(void) {
 	udev_monitor_unref(MON);
 	udev_unref(UDEV);
 
+	GamepadRumbleShutdown();
+	GamepadMappingShutdown();
+	GamepadUringShutdown();
+
 	/* cleanup devices */
 	for (i = 0; i != GAMEPAD_COUNT; ++i) {
-		if (STATE[i].device != NULL) {
-			free(STATE[i].device);
+		if (NODE[i].fd != -1) {
+			close(NODE[i].fd);
+			NODE[i].fd = -1;
 		}
-
-		if (STATE[i].fd != -1) {
-			close(STATE[i].fd);
+		if (NODE[i].ffd != -1) {
+			close(NODE[i].ffd);
+			NODE[i].ffd = -1;
 		}
+		GamepadMotionDetach((GAMEPAD_DEVICE)i);
 	}
-}
-
-void GamepadSetRumble(GAMEPAD_DEVICE gamepad, float left, float right) {
-	if (STATE[gamepad].fd != -1) {
-		struct input_event play;
-
-		/* delete any existing effect */
-		if (STATE[gamepad].effect != -1) {
-			/* stop the effect */
-			play.type = EV_FF;
-			play.code = STATE[gamepad].effect;
-			play.value = 0;
 
-			write(STATE[gamepad].fd, (const void*)&play, sizeof(play));
+	if (EPOLL != -1) {
+		close(EPOLL);
+		EPOLL = -1;
+	}
+}
 
-			/* delete the effect */
-			ioctl(STATE[gamepad].fd, EVIOCRMFF, STATE[gamepad].effect);
-		}
+/*
+ * One effect per device is uploaded once and then updated in place, so a
+ * change costs a single EVIOCSFF; starting or stopping adds one write.
+ */
+GAMEPAD_BOOL GamepadRumbleOutput(GAMEPAD_DEVICE gamepad, unsigned short strong, unsigned short weak) {
+	GAMEPAD_NODE* node = &NODE[gamepad];
+	struct input_event play;
+	struct ff_effect ff;
 
-		/* if rumble parameters are non-zero, start the new effect */
-		if (left != 0.f || right != 0.f) {
-			struct ff_effect ff;
+	if ((STATE[gamepad].flags & FLAG_RUMBLE) == 0) {
+		return GAMEPAD_FALSE;
+	}
 
-			/* define an effect for this rumble setting */
-			ff.type = FF_RUMBLE;
-			ff.id = -1;
-			ff.u.rumble.strong_magnitude = (unsigned short)(left * 65535);
-			ff.u.rumble.weak_magnitude = (unsigned short)(right * 65535);
-			ff.replay.length = 5;
-			ff.replay.delay = 0;
+	memset(&play, 0, sizeof(play));
+	play.type = EV_FF;
 
-			/* upload the effect */
-			if (ioctl(STATE[gamepad].fd, EVIOCSFF, &ff) != -1) {
-				STATE[gamepad].effect = ff.id;
+	if (strong == 0 && weak == 0) {
+		/* keep the effect uploaded for the next start */
+		if (node->rumbling) {
+			play.code = node->effect;
+			play.value = 0;
+			if (write(node->ffd, &play, sizeof(play)) != sizeof(play)) {
+				return GAMEPAD_FALSE;
 			}
+			node->rumbling = GAMEPAD_FALSE;
+		}
+		return GAMEPAD_TRUE;
+	}
 
-			/* play the effect */
-			play.type = EV_FF;
-			play.code = STATE[gamepad].effect;
-			play.value = 1;
+	/* a zero length plays until stopped */
+	memset(&ff, 0, sizeof(ff));
+	ff.type = FF_RUMBLE;
+	ff.id = node->effect;
+	ff.u.rumble.strong_magnitude = strong;
+	ff.u.rumble.weak_magnitude = weak;
+	if (ioctl(node->ffd, EVIOCSFF, &ff) == -1) {
+		return GAMEPAD_FALSE;
+	}
+	node->effect = ff.id;
 
-			write(STATE[gamepad].fd, (const void*)&play, sizeof(play));
+	if (!node->rumbling) {
+		play.code = node->effect;
+		play.value = 1;
+		if (write(node->ffd, &play, sizeof(play)) != sizeof(play)) {
+			return GAMEPAD_FALSE;
 		}
+		node->rumbling = GAMEPAD_TRUE;
 	}
+	return GAMEPAD_TRUE;
 }
 
 #else /* !defined(_WIN32) && !defined(__linux__) */
@@ -444,6 +833,10 @@ void GamepadSetRumble(GAMEPAD_DEVICE gamepad, float left, float right) {
 
 #endif /* end of platform implementations */
 
+unsigned long long GamepadClock(void) {
+	return GamepadTimeMicros();
+}
+
 GAMEPAD_BOOL GamepadIsConnected(GAMEPAD_DEVICE device) {
 	return (STATE[device].flags & FLAG_CONNECTED) != 0 ? GAMEPAD_TRUE : GAMEPAD_FALSE;
 }
@@ -467,11 +860,11 @@ int GamepadTriggerValue(GAMEPAD_DEVICE device, GAMEPAD_TRIGGER trigger) {
 }
 
 float GamepadTriggerLength(GAMEPAD_DEVICE device, GAMEPAD_TRIGGER trigger) {
-	return STATE[device].trigger[trigger].length;
+	return TRIGGER_LENGTH(&STATE[device].trigger[trigger]);
 }
 
 GAMEPAD_BOOL GamepadTriggerDown(GAMEPAD_DEVICE device, GAMEPAD_TRIGGER trigger) {
-	return STATE[device].trigger[trigger].pressedCurrent;
+	return (GAMEPAD_BOOL)STATE[device].trigger[trigger].pressedCurrent;
 }
 
 GAMEPAD_BOOL GamepadTriggerTriggered(GAMEPAD_DEVICE device, GAMEPAD_TRIGGER trigger) {
@@ -490,20 +883,20 @@ void GamepadStickXY(GAMEPAD_DEVICE device, GAMEPAD_STICK stick, int *outX, int *
 }
 
 float GamepadStickLength(GAMEPAD_DEVICE device, GAMEPAD_STICK stick) {
-	return STATE[device].stick[stick].length;
+	return AXIS_LENGTH(&STATE[device].stick[stick]);
 }
 
 void GamepadStickNormXY(GAMEPAD_DEVICE device, GAMEPAD_STICK stick, float *outX, float *outY) {
-	*outX = STATE[device].stick[stick].nx;
-	*outY = STATE[device].stick[stick].ny;
+	*outX = AXIS_NX(&STATE[device].stick[stick]);
+	*outY = AXIS_NY(&STATE[device].stick[stick]);
 }
 
 float GamepadStickAngle(GAMEPAD_DEVICE device, GAMEPAD_STICK stick) {
-	return STATE[device].stick[stick].angle;
+	return AXIS_ANGLE(&STATE[device].stick[stick]);
 }
 
 GAMEPAD_STICKDIR GamepadStickDir(GAMEPAD_DEVICE device, GAMEPAD_STICK stick) {
-	return STATE[device].stick[stick].dirCurrent;
+	return (GAMEPAD_STICKDIR)STATE[device].stick[stick].dirCurrent;
 }
 
 GAMEPAD_BOOL GamepadStickDirTriggered(GAMEPAD_DEVICE device, GAMEPAD_STICK stick, GAMEPAD_STICKDIR dir) {
@@ -511,6 +904,38 @@ GAMEPAD_BOOL GamepadStickDirTriggered(GAMEPAD_DEVICE device, GAMEPAD_STICK stick
 			STATE[device].stick[stick].dirCurrent != STATE[device].stick[stick].dirLast) ? GAMEPAD_TRUE : GAMEPAD_FALSE;
 }
 
+void GamepadGetSnapshot(GAMEPAD_DEVICE device, GAMEPAD_SNAPSHOT* snapshot) {
+	const GAMEPAD_STATE* state = &STATE[device];
+	int i;
+
+	snapshot->connected = (state->flags & FLAG_CONNECTED) != 0 ? GAMEPAD_TRUE : GAMEPAD_FALSE;
+	snapshot->buttons = (unsigned int)state->bCurrent;
+	snapshot->buttonsLast = (unsigned int)state->bLast;
+	snapshot->triggers = snapshot->triggersLast = 0;
+
+	for (i = 0; i != TRIGGER_COUNT; ++i) {
+		if (state->trigger[i].pressedCurrent) {
+			snapshot->triggers |= GAMEPAD_MASK(i);
+		}
+		if (state->trigger[i].pressedLast) {
+			snapshot->triggersLast |= GAMEPAD_MASK(i);
+		}
+		snapshot->triggerValue[i] = state->trigger[i].value;
+		snapshot->triggerLength[i] = TRIGGER_LENGTH(&state->trigger[i]);
+	}
+
+	for (i = 0; i != STICK_COUNT; ++i) {
+		snapshot->stickX[i] = state->stick[i].x;
+		snapshot->stickY[i] = state->stick[i].y;
+		snapshot->stickNX[i] = AXIS_NX(&state->stick[i]);
+		snapshot->stickNY[i] = AXIS_NY(&state->stick[i]);
+		snapshot->stickLength[i] = AXIS_LENGTH(&state->stick[i]);
+		snapshot->stickAngle[i] = AXIS_ANGLE(&state->stick[i]);
+		snapshot->stickDir[i] = (GAMEPAD_STICKDIR)state->stick[i].dirCurrent;
+		snapshot->stickDirLast[i] = (GAMEPAD_STICKDIR)state->stick[i].dirLast;
+	}
+}
+
 /* initialize common gamepad state */
 static void GamepadResetState(GAMEPAD_DEVICE gamepad) {
 	memset(STATE[gamepad].stick, 0, sizeof(STATE[gamepad].stick));
@@ -520,13 +945,14 @@ static void GamepadResetState(GAMEPAD_DEVICE gamepad) {
 
 /* Update individual sticks */
 static void GamepadUpdateCommon(void) {
-	int i;
+	int i, j;
 	for (i = 0; i != GAMEPAD_COUNT; ++i) {
 		/* store previous button state */
 		STATE[i].bLast = STATE[i].bCurrent;
 
 		/* per-platform update routines */
 		GamepadUpdateDevice((GAMEPAD_DEVICE)i);
+		GamepadMotionUpdate((GAMEPAD_DEVICE)i);
 
 		/* calculate refined stick and trigger values */
 		if ((STATE[i].flags & FLAG_CONNECTED) != 0) {
@@ -535,12 +961,38 @@ static void GamepadUpdateCommon(void) {
 
 			GamepadUpdateTrigger(&STATE[i].trigger[TRIGGER_LEFT]);
 			GamepadUpdateTrigger(&STATE[i].trigger[TRIGGER_RIGHT]);
+
+			/* notify subscribers of derived state changes */
+			for (j = 0; j != STICK_COUNT; ++j) {
+				if (STATE[i].stick[j].dirCurrent != STATE[i].stick[j].dirLast) {
+					GamepadEmitEvent((GAMEPAD_DEVICE)i, EVENT_STICK_DIR, j, STATE[i].stick[j].dirCurrent, STATE[i].time);
+				}
+			}
+			for (j = 0; j != TRIGGER_COUNT; ++j) {
+				if (STATE[i].trigger[j].pressedCurrent != STATE[i].trigger[j].pressedLast) {
+					GamepadEmitEvent((GAMEPAD_DEVICE)i, STATE[i].trigger[j].pressedCurrent ? EVENT_TRIGGER_DOWN : EVENT_TRIGGER_UP,
+						j, STATE[i].trigger[j].value, STATE[i].time);
+				}
+			}
+		}
+
+		/* later events of this device come from no input */
+		GamepadLatencyDone((GAMEPAD_DEVICE)i);
+
+		/* holds complete without any input arriving */
+		if ((STATE[i].flags & FLAG_CONNECTED) != 0 && GamepadGestureHolds()) {
+			GamepadGestureTick((GAMEPAD_DEVICE)i, GamepadTimeMicros());
 		}
 	}
+
+	/* push rumble levels that changed since the last update */
+	GamepadRumbleUpdate(GamepadTimeMicros());
 }
 
+#if !defined(GAMEPAD_FIXED_POINT)
+
 /* Update stick info */
-static void GamepadUpdateStick(GAMEPAD_AXIS* axis, float deadzone) {
+static void GamepadUpdateStick(GAMEPAD_AXIS* axis, int deadzone) {
 	// determine magnitude of stick
 	axis->length = sqrtf((float)(axis->x*axis->x) + (float)(axis->y*axis->y));
 
@@ -597,3 +1049,82 @@ static void GamepadUpdateTrigger(GAMEPAD_TRIGINFO* trig) {
 		trig->pressedCurrent = GAMEPAD_FALSE;
 	}
 }
+
+#else /* defined(GAMEPAD_FIXED_POINT) */
+
+/* Integer square root of a 32-bit value, one result bit per step without branches */
+static unsigned int GamepadISqrt(unsigned int v) {
+	unsigned int root = 0, bit = 1u << 30, t, m;
+
+	while (bit != 0) {
+		t = root + bit;
+		m = 0u - (unsigned int)(v >= t);
+		v -= t & m;
+		root = (root >> 1) + (bit & m);
+		bit >>= 2;
+	}
+	return root;
+}
+
+/* Update stick info in Q15 */
+static void GamepadUpdateStick(GAMEPAD_AXIS* axis, int deadzone) {
+	int x = axis->x, y = axis->y;
+	int ax = x < 0 ? -x : x, ay = y < 0 ? -y : y;
+	unsigned int lengthSq = (unsigned int)(ax * ax) + (unsigned int)(ay * ay);
+	unsigned int length, recip;
+	int nx, ny;
+
+	axis->dirLast = axis->dirCurrent;
+
+	/* the deadzone test doesn't need the root */
+	if (lengthSq > (unsigned int)(deadzone * deadzone)) {
+		length = GamepadISqrt(lengthSq);
+
+		// clamp length to maximum value
+		if (length > 32767) {
+			length = 32767;
+		}
+
+		// normalized X and Y values through one division, clamped like the length
+		recip = (1u << 31) / length;
+		nx = (int)(((long long)x * recip) >> 16);
+		ny = (int)(((long long)y * recip) >> 16);
+		axis->nx = (short)(nx > 32767 ? 32767 : (nx < -32767 ? -32767 : nx));
+		axis->ny = (short)(ny > 32767 ? 32767 : (ny < -32767 ? -32767 : ny));
+
+		// adjust length for deadzone and find normalized length
+		axis->length = (unsigned short)(((length - deadzone) << 15) / (32767 - deadzone));
+
+		/* the larger component picks the direction; diagonals go counter-clockwise like the angle ranges */
+		if (ax > ay) {
+			axis->dirCurrent = x > 0 ? STICKDIR_RIGHT : STICKDIR_LEFT;
+		} else if (ay > ax) {
+			axis->dirCurrent = y > 0 ? STICKDIR_UP : STICKDIR_DOWN;
+		} else if (y > 0) {
+			axis->dirCurrent = x > 0 ? STICKDIR_UP : STICKDIR_LEFT;
+		} else {
+			axis->dirCurrent = x < 0 ? STICKDIR_DOWN : STICKDIR_RIGHT;
+		}
+	} else {
+		axis->x = axis->y = 0;
+		axis->nx = axis->ny = 0;
+		axis->length = 0;
+		axis->dirCurrent = STICKDIR_CENTER;
+	}
+}
+
+/* Update trigger info in Q15 */
+static void GamepadUpdateTrigger(GAMEPAD_TRIGINFO* trig) {
+	trig->pressedLast = trig->pressedCurrent;
+
+	if (trig->value > GAMEPAD_DEADZONE_TRIGGER) {
+		trig->length = (unsigned short)(((trig->value - GAMEPAD_DEADZONE_TRIGGER) << 15) / (255 - GAMEPAD_DEADZONE_TRIGGER));
+		trig->pressedCurrent = GAMEPAD_TRUE;
+	} else {
+		trig->value = 0;
+		trig->length = 0;
+		trig->pressedCurrent = GAMEPAD_FALSE;
+	}
+}
+
+#endif
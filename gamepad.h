@@ -56,6 +56,7 @@ enum GAMEPAD_BUTTON {
 	BUTTON_RIGHT_THUMB		= 7,	/**< Right analog stick button */
 	BUTTON_LEFT_SHOULDER	= 8,	/**< Left bumper button */
 	BUTTON_RIGHT_SHOULDER	= 9,	/**< Right bumper button */
+	BUTTON_GUIDE			= 10,	/**< Guide/home button */
 	BUTTON_A				= 12,	/**< A button */
 	BUTTON_B				= 13,	/**< B button */
 	BUTTON_X				= 14,	/**< X button */
@@ -107,12 +108,165 @@ enum GAMEPAD_BOOL {
 	GAMEPAD_TRUE	= 1		/**< TRUE value for boolean parameters */
 };
 
+/**
+ * Enumeration of the events delivered to subscribers.
+ */
+enum GAMEPAD_EVENT_TYPE {
+	EVENT_CONNECTED		= 0,	/**< Device was connected */
+	EVENT_DISCONNECTED	= 1,	/**< Device was disconnected */
+	EVENT_BUTTON_DOWN	= 2,	/**< Button was pressed */
+	EVENT_BUTTON_UP		= 3,	/**< Button was released */
+	EVENT_TRIGGER_DOWN	= 4,	/**< Trigger was pressed past its deadzone */
+	EVENT_TRIGGER_UP	= 5,	/**< Trigger was released */
+	EVENT_STICK_DIR		= 6,	/**< Stick direction changed */
+	EVENT_AXIS			= 7,	/**< Stick moved by more than the subscription threshold */
+	EVENT_GESTURE		= 8,	/**< A gesture registered with GamepadGestureAdd was performed */
+
+	EVENT_COUNT					/**< Number of event types */
+};
+
+/**
+ * Enumeration of what an event channel does when it is full.
+ */
+enum GAMEPAD_OVERFLOW {
+	OVERFLOW_DROP_NEWEST	= 0,	/**< Discard the event that does not fit */
+	OVERFLOW_DROP_OLDEST	= 1		/**< Discard the oldest queued event to make room */
+};
+
 typedef enum GAMEPAD_DEVICE GAMEPAD_DEVICE;
 typedef enum GAMEPAD_BUTTON GAMEPAD_BUTTON;
 typedef enum GAMEPAD_TRIGGER GAMEPAD_TRIGGER;
 typedef enum GAMEPAD_STICK GAMEPAD_STICK;
 typedef enum GAMEPAD_STICKDIR GAMEPAD_STICKDIR;
 typedef enum GAMEPAD_BOOL GAMEPAD_BOOL;
+typedef enum GAMEPAD_EVENT_TYPE GAMEPAD_EVENT_TYPE;
+typedef enum GAMEPAD_OVERFLOW GAMEPAD_OVERFLOW;
+
+/**
+ * An input event.
+ */
+typedef struct GAMEPAD_EVENT GAMEPAD_EVENT;
+struct GAMEPAD_EVENT {
+	GAMEPAD_EVENT_TYPE type;	/**< What happened */
+	GAMEPAD_DEVICE device;		/**< Device it happened on */
+	int input;					/**< Button, trigger, stick or gesture, depending on the type */
+	int value;					/**< Stick direction for EVENT_STICK_DIR, trigger value for trigger events */
+	int x, y;					/**< Raw stick position for EVENT_AXIS */
+	unsigned int time;			/**< Device timestamp in milliseconds */
+	unsigned long long stamp;	/**< Time GamepadUpdate applied the input, in microseconds on the GamepadClock timeline */
+	unsigned long long kernelStamp;	/**< Time the kernel stamped the input, estimated on the same timeline */
+	unsigned long long readStamp;	/**< Time the library took the input from the device, on the same timeline */
+};
+
+/**
+ * Copy of a device's state, for callers that query many inputs at once.
+ */
+typedef struct GAMEPAD_SNAPSHOT GAMEPAD_SNAPSHOT;
+struct GAMEPAD_SNAPSHOT {
+	unsigned int buttons;						/**< Buttons down, one GAMEPAD_MASK bit per GAMEPAD_BUTTON */
+	unsigned int buttonsLast;					/**< Buttons down before the last update */
+	unsigned int triggers;						/**< Triggers down, one GAMEPAD_MASK bit per GAMEPAD_TRIGGER */
+	unsigned int triggersLast;					/**< Triggers down before the last update */
+	int triggerValue[TRIGGER_COUNT];			/**< Raw trigger values (0 to 255) */
+	float triggerLength[TRIGGER_COUNT];			/**< Normalized trigger values (0 to 1) */
+	int stickX[STICK_COUNT], stickY[STICK_COUNT];	/**< Raw stick positions */
+	float stickNX[STICK_COUNT], stickNY[STICK_COUNT];	/**< Normalized stick positions */
+	float stickLength[STICK_COUNT];				/**< Stick magnitudes (0 to 1) */
+	float stickAngle[STICK_COUNT];				/**< Stick angles in radians */
+	GAMEPAD_STICKDIR stickDir[STICK_COUNT];		/**< Current stick directions */
+	GAMEPAD_STICKDIR stickDirLast[STICK_COUNT];	/**< Stick directions before the last update */
+	GAMEPAD_BOOL connected;						/**< Whether the device is connected */
+};
+
+/**
+ * A timed rumble effect.
+ *
+ * The envelope ramps from attackLevel times the magnitude up to the full
+ * magnitude over the attack, and from the full magnitude down to fadeLevel
+ * times the magnitude over the fade at the end of the effect.
+ */
+typedef struct GAMEPAD_RUMBLE GAMEPAD_RUMBLE;
+struct GAMEPAD_RUMBLE {
+	float left;					/**< Left (strong) motor magnitude (0 to 1) */
+	float right;				/**< Right (weak) motor magnitude (0 to 1) */
+	unsigned int delay;			/**< Milliseconds before the effect starts */
+	unsigned int duration;		/**< Milliseconds the effect lasts, or 0 to play until stopped */
+	unsigned int attack;		/**< Length of the attack in milliseconds */
+	float attackLevel;			/**< Starting level of the attack (0 to 1) */
+	unsigned int fade;			/**< Length of the fade in milliseconds; ignored without a duration */
+	float fadeLevel;			/**< Final level of the fade (0 to 1) */
+	int priority;				/**< Only the highest priority effects playing are heard */
+};
+
+/**
+ * Replacement for the device's motors, see GamepadSetRumbleSink.
+ *
+ * \param device The device being written to.
+ * \param strong Left (strong) motor level (0 to 65535).
+ * \param weak Right (weak) motor level (0 to 65535).
+ * \param user The pointer given to GamepadSetRumbleSink.
+ * \returns GAMEPAD_TRUE if the levels were taken, GAMEPAD_FALSE to have them sent again.
+ */
+typedef GAMEPAD_BOOL (*GAMEPAD_RUMBLE_SINK)(GAMEPAD_DEVICE device, unsigned short strong, unsigned short weak, void* user);
+
+/**
+ * A haptic waveform stream playing on a device.
+ */
+typedef struct GAMEPAD_WAVEFORM GAMEPAD_WAVEFORM;
+
+/**
+ * A motion sensor sample.
+ *
+ * Axes follow the evdev convention for the device; for most pads X points
+ * right, Y towards the player and Z up out of the face buttons.
+ */
+typedef struct GAMEPAD_MOTION GAMEPAD_MOTION;
+struct GAMEPAD_MOTION {
+	float accel[3];				/**< Acceleration in m/s^2, including gravity */
+	float gyro[3];				/**< Angular velocity in rad/s, calibration bias removed */
+	float dt;					/**< Seconds since the previous sample by the sensor's clock, 0 for the first */
+	unsigned long long time;	/**< Arrival time in microseconds, on the GamepadClock timeline */
+};
+
+#define GAMEPAD_LATENCY_BUCKETS	12		/**< Histogram buckets in GAMEPAD_LATENCY */
+#define GAMEPAD_LATENCY_WINDOW	512		/**< Latest inputs per device the histogram covers */
+
+/**
+ * How stale a device's input is.
+ *
+ * Latency is measured from the kernel's timestamp of an input to the update
+ * that applied it.  Bucket i of the histogram counts latencies below
+ * 125 << i microseconds (125 us to 128 ms); the last bucket counts the rest.
+ */
+typedef struct GAMEPAD_LATENCY GAMEPAD_LATENCY;
+struct GAMEPAD_LATENCY {
+	unsigned int pending;		/**< Inputs applied since the previous GamepadGetLatency */
+	unsigned int oldestAge;		/**< Microseconds from the kernel stamp of the oldest of them to now, 0 if none */
+	unsigned int newestAge;		/**< Microseconds from the kernel stamp of the newest of them to now, 0 if none */
+	unsigned int samples;		/**< Inputs in the histogram, up to GAMEPAD_LATENCY_WINDOW */
+	unsigned int histogram[GAMEPAD_LATENCY_BUCKETS];	/**< Latency of the latest inputs */
+};
+
+/**
+ * Callback invoked for subscribed events.
+ *
+ * \param event The event, only valid for the duration of the call.
+ * \param user The pointer given to GamepadSubscribe.
+ */
+typedef void (*GAMEPAD_CALLBACK)(const GAMEPAD_EVENT* event, void* user);
+
+/**
+ * Bounded lock-free queue of events for consumers on other threads.
+ */
+typedef struct GAMEPAD_CHANNEL GAMEPAD_CHANNEL;
+
+#define GAMEPAD_MASK(x)			(1u << (x))		/**< Mask bit for a device, event type or input */
+#define GAMEPAD_MASK_ALL		(~0u)			/**< Mask matching everything */
+
+#define GAMEPAD_GESTURE_DIR(d)		((d) - 1)		/**< Gesture symbol for a direction in numpad notation (1 to 9, 5 is neutral) */
+#define GAMEPAD_GESTURE_PRESS(b)	(16 + (b))		/**< Gesture symbol for a button press */
+#define GAMEPAD_GESTURE_RELEASE(b)	(32 + (b))		/**< Gesture symbol for a button release */
+#define GAMEPAD_GESTURE_HOLD(b)		(48 + (b))		/**< Gesture symbol for a button held for the hold time */
 
 #define GAMEPAD_DEADZONE_LEFT_STICK		7849	/**< Suggested deadzone magnitude for left analog stick */
 #define	GAMEPAD_DEADZONE_RIGHT_STICK	8689	/**< Suggested deadzone magnitude for right analog stick */
@@ -141,6 +295,39 @@ GAMEPAD_API void GamepadShutdown(void);
  */
 GAMEPAD_API void GamepadUpdate(void);
 
+/**
+ * Block until there is input (or a device change) to process.
+ *
+ * Call GamepadUpdate afterwards to process it.  This lets input-driven programs
+ * sleep instead of spinning on GamepadUpdate.
+ *
+ * \param timeout Maximum time to wait in milliseconds, 0 to poll, or -1 to wait forever.
+ * \returns GAMEPAD_TRUE if there is input to process, GAMEPAD_FALSE if the timeout expired.
+ */
+GAMEPAD_API GAMEPAD_BOOL GamepadWait(int timeout);
+
+/**
+ * Add a controller mapping in SDL gamecontrollerdb format.
+ *
+ * A mapping is a single line of the form "GUID,name,a:b0,b:b1,...,platform:Linux,".
+ * Mappings for other platforms are ignored.  Connected devices pick up a new
+ * mapping immediately; devices without a mapping use the Xbox 360 layout.
+ *
+ * Mappings only affect raw joystick devices, XInput devices are always mapped natively.
+ *
+ * \param mapping The mapping line.
+ * \returns 1 if a new mapping was added, 0 if an existing one was replaced or the line was ignored, -1 on error.
+ */
+GAMEPAD_API int GamepadAddMapping(const char* mapping);
+
+/**
+ * Load every mapping from a gamecontrollerdb.txt file.
+ *
+ * \param path Path of the file to load.
+ * \returns The number of mappings added, or -1 if the file could not be read.
+ */
+GAMEPAD_API int GamepadAddMappingsFromFile(const char* path);
+
 /**
  * Test if a particular gamepad is connected.
  *
@@ -149,6 +336,27 @@ GAMEPAD_API void GamepadUpdate(void);
  */
 GAMEPAD_API GAMEPAD_BOOL GamepadIsConnected(GAMEPAD_DEVICE device);
 
+/**
+ * Test if a device was restored on its most recent connection.
+ *
+ * A device that reconnects (e.g. over a flaky wireless link) returns to the slot
+ * it had before and reuses its cached layout, mapping and calibration.
+ *
+ * \param device The device to check.
+ * \returns GAMEPAD_TRUE if the device was restored, GAMEPAD_FALSE if it was probed from scratch.
+ */
+GAMEPAD_API GAMEPAD_BOOL GamepadIsRestored(GAMEPAD_DEVICE device);
+
+/**
+ * Query how long the most recent connection of a device took to become usable.
+ *
+ * This is measured from the hotplug notification to the device being ready to read.
+ *
+ * \param device The device to check.
+ * \returns The attach time in microseconds, or 0 if it is not known.
+ */
+GAMEPAD_API unsigned int GamepadAttachTime(GAMEPAD_DEVICE device);
+
 /**
  * Test if a particular button is being pressed.
  *
@@ -228,12 +436,135 @@ GAMEPAD_API GAMEPAD_BOOL GamepadTriggerReleased(GAMEPAD_DEVICE device, GAMEPAD_T
  *
  * The left motor is the low-frequency/strong motor, and the right motor is the high-frequency/weak motor.
  *
+ * The setting persists until changed and is mixed with playing effects at
+ * priority 0.  It reaches the device on the next GamepadUpdate.
+ *
  * \param device The device to update.
  * \param left Left motor strengh (0 to 1).
  * \param right Right motor strengh (0 to 1).
  */
 GAMEPAD_API void GamepadSetRumble(GAMEPAD_DEVICE device, float left, float right);
 
+/**
+ * Start a timed rumble effect.
+ *
+ * Effects are mixed in GamepadUpdate: the playing effects with the highest
+ * priority are added together, and the device is only written to when the
+ * mixed output changes.
+ *
+ * \param device The device to rumble.
+ * \param effect The effect to play; it is copied.
+ * \returns A handle for GamepadRumbleStop, or -1 if too many effects are playing.
+ */
+GAMEPAD_API int GamepadRumblePlay(GAMEPAD_DEVICE device, const GAMEPAD_RUMBLE* effect);
+
+/**
+ * Stop a rumble effect before it ends.
+ *
+ * Handles of effects that already ended are ignored.
+ *
+ * \param effect The handle returned by GamepadRumblePlay.
+ */
+GAMEPAD_API void GamepadRumbleStop(int effect);
+
+/**
+ * Stop every effect on a device, including the GamepadSetRumble setting.
+ *
+ * \param device The device to silence.
+ */
+GAMEPAD_API void GamepadRumbleStopAll(GAMEPAD_DEVICE device);
+
+/**
+ * Send motor levels somewhere other than the devices.
+ *
+ * Every write the library would make to a device's motors goes to the sink
+ * instead, whether or not a device is connected.  This is meant for tests and
+ * tools that record rumble output.  The sink is called from the thread that
+ * calls GamepadUpdate and from waveform threads, one call at a time.
+ *
+ * \param sink The function to call, or NULL to write to the devices again.
+ * \param user Pointer passed to the sink.
+ */
+GAMEPAD_API void GamepadSetRumbleSink(GAMEPAD_RUMBLE_SINK sink, void* user);
+
+/**
+ * Query the clock used for waveform start times and event stamps.
+ *
+ * \returns Monotonic time in microseconds.
+ */
+GAMEPAD_API unsigned long long GamepadClock(void);
+
+/**
+ * Create a waveform stream for a device.
+ *
+ * A stream plays samples of both motor levels at a fixed rate from its own
+ * thread, so playback timing does not depend on the frame rate.  It has two
+ * buffers: one plays while the other is refilled with GamepadWaveformQueue.
+ * While a stream is playing it overrides the rumble effects of its device.
+ *
+ * \param device The device to play on.
+ * \param rate Samples per second.
+ * \param capacity Samples each of the two buffers holds.
+ * \returns The stream, or NULL if it could not be created.
+ */
+GAMEPAD_API GAMEPAD_WAVEFORM* GamepadWaveformCreate(GAMEPAD_DEVICE device, unsigned int rate, unsigned int capacity);
+
+/**
+ * Stop a stream and free it.
+ *
+ * \param waveform The stream to destroy.
+ */
+GAMEPAD_API void GamepadWaveformDestroy(GAMEPAD_WAVEFORM* waveform);
+
+/**
+ * Fill the free buffer of a stream.
+ *
+ * Samples are pairs of left (strong) and right (weak) motor levels, 0 to
+ * 65535.  Buffers play in the order they were queued.  If the playing thread
+ * runs out of samples the motors stop until more are queued, and the missed
+ * sample times are skipped so later samples keep their timing.
+ *
+ * \param waveform The stream to fill.
+ * \param samples Interleaved strong and weak levels, two values per sample.
+ * \param count Number of samples.
+ * \returns Number of samples taken (at most the capacity), or 0 if both buffers are full.
+ */
+GAMEPAD_API unsigned int GamepadWaveformQueue(GAMEPAD_WAVEFORM* waveform, const unsigned short* samples, unsigned int count);
+
+/**
+ * Start playing a stream.
+ *
+ * Sample n is written at start + n / rate seconds.
+ *
+ * \param waveform The stream to start.
+ * \param start GamepadClock time of the first sample, or 0 to start now.
+ * \returns GAMEPAD_TRUE if playback started.
+ */
+GAMEPAD_API GAMEPAD_BOOL GamepadWaveformStart(GAMEPAD_WAVEFORM* waveform, unsigned long long start);
+
+/**
+ * Stop playing a stream and discard its queued samples.
+ *
+ * \param waveform The stream to stop.
+ */
+GAMEPAD_API void GamepadWaveformStop(GAMEPAD_WAVEFORM* waveform);
+
+/**
+ * Query how far a stream has played.
+ *
+ * \param waveform The stream to check.
+ * \returns Number of sample times passed since the start, including ones skipped for lack of samples.
+ */
+GAMEPAD_API unsigned int GamepadWaveformPosition(GAMEPAD_WAVEFORM* waveform);
+
+/**
+ * Query how many sample times passed without a sample to play.
+ *
+ * \param waveform The stream to check.
+ * \returns Number of samples missed since the start.
+ */
+GAMEPAD_API unsigned int GamepadWaveformUnderruns(GAMEPAD_WAVEFORM* waveform);
+
 /**
  * Query the position of an analog stick as raw values.
  *
@@ -316,6 +647,265 @@ GAMEPAD_API GAMEPAD_STICKDIR GamepadStickDir(GAMEPAD_DEVICE device, GAMEPAD_STIC
  */
 GAMEPAD_API GAMEPAD_BOOL GamepadStickDirTriggered(GAMEPAD_DEVICE device, GAMEPAD_STICK stick, GAMEPAD_STICKDIR dir);
 
+/**
+ * Copy the complete state of a device.
+ *
+ * One call replaces a series of accessor calls; the values match what the
+ * accessors return until the next GamepadUpdate.
+ *
+ * \param device The device to copy.
+ * \param snapshot Receives the state.
+ */
+GAMEPAD_API void GamepadGetSnapshot(GAMEPAD_DEVICE device, GAMEPAD_SNAPSHOT* snapshot);
+
+/**
+ * Register a callback for input events.
+ *
+ * Callbacks are invoked from within GamepadUpdate as soon as the input is decoded,
+ * so several events of the same kind may arrive within one update.  Filtering is
+ * done before any event is built, so inputs nobody subscribed to cost nothing.
+ *
+ * The input mask selects buttons (GAMEPAD_MASK(BUTTON_A)), triggers or sticks
+ * depending on the event type; subscribe separately to combine different kinds.
+ * It is ignored for connection events.  Devices that are already connected when
+ * the subscription is made do not produce EVENT_CONNECTED.
+ *
+ * \param devices Mask of devices to listen to, e.g. GAMEPAD_MASK(GAMEPAD_0), or GAMEPAD_MASK_ALL.
+ * \param events Mask of event types, e.g. GAMEPAD_MASK(EVENT_BUTTON_DOWN).
+ * \param inputs Mask of inputs, or GAMEPAD_MASK_ALL.
+ * \param threshold Minimum change of either stick coordinate before EVENT_AXIS is sent again.
+ * \param callback The function to call.
+ * \param user Pointer passed back to the callback.
+ * \returns A subscription handle, or -1 if too many subscriptions are registered.
+ */
+GAMEPAD_API int GamepadSubscribe(unsigned int devices, unsigned int events, unsigned int inputs, int threshold, GAMEPAD_CALLBACK callback, void* user);
+
+/**
+ * Remove a subscription.
+ *
+ * This is safe to call from within a callback.
+ *
+ * \param subscription The handle returned by GamepadSubscribe.
+ */
+GAMEPAD_API void GamepadUnsubscribe(int subscription);
+
+/**
+ * Create a channel that receives events on another thread.
+ *
+ * The library publishes matching events into the channel as they are decoded,
+ * with the same filtering as GamepadSubscribe.  Other threads may push events of
+ * their own, but only one thread may pop.
+ *
+ * Create and destroy channels on the thread that calls GamepadUpdate.
+ *
+ * \param capacity Number of events the channel can hold (rounded up to a power of two).
+ * \param overflow What to do with events that don't fit.
+ * \param devices Mask of devices to listen to.
+ * \param events Mask of event types.
+ * \param inputs Mask of inputs.
+ * \param threshold Minimum change of either stick coordinate between EVENT_AXIS events.
+ * \returns The channel, or NULL if it could not be created.
+ */
+GAMEPAD_API GAMEPAD_CHANNEL* GamepadChannelCreate(unsigned int capacity, GAMEPAD_OVERFLOW overflow,
+	unsigned int devices, unsigned int events, unsigned int inputs, int threshold);
+
+/**
+ * Destroy a channel, discarding any queued events.
+ *
+ * \param channel The channel to destroy.
+ */
+GAMEPAD_API void GamepadChannelDestroy(GAMEPAD_CHANNEL* channel);
+
+/**
+ * Queue an event into a channel.  This may be called from any thread.
+ *
+ * \param channel The channel to push to.
+ * \param event The event to queue.
+ * \returns GAMEPAD_TRUE if the event was queued, GAMEPAD_FALSE if it was dropped.
+ */
+GAMEPAD_API GAMEPAD_BOOL GamepadChannelPush(GAMEPAD_CHANNEL* channel, const GAMEPAD_EVENT* event);
+
+/**
+ * Take the oldest event out of a channel.  Only one thread may pop from a channel.
+ *
+ * \param channel The channel to pop from.
+ * \param event Receives the event.
+ * \returns GAMEPAD_TRUE if an event was returned, GAMEPAD_FALSE if the channel is empty.
+ */
+GAMEPAD_API GAMEPAD_BOOL GamepadChannelPop(GAMEPAD_CHANNEL* channel, GAMEPAD_EVENT* event);
+
+/**
+ * Query how many events a channel has dropped because it was full.
+ *
+ * \param channel The channel to check.
+ * \returns The number of dropped events since the channel was created.
+ */
+GAMEPAD_API unsigned int GamepadChannelDropped(GAMEPAD_CHANNEL* channel);
+
+/**
+ * Register a gesture.
+ *
+ * A pattern is a list of symbols separated by spaces:
+ *
+ *  - 1 to 9: the left stick or d-pad entering a direction, in numpad notation
+ *    (2 is down, 6 is right, 5 is neutral).  The d-pad wins over the stick.
+ *  - a button name, optionally with a leading '+': the button is pressed.
+ *    Names are as in mapping strings: a, b, x, y, back, guide, start,
+ *    leftstick, rightstick, leftshoulder, rightshoulder, dpup, dpdown,
+ *    dpleft and dpright.
+ *  - '-' and a button name: the button is released.
+ *  - a button name in brackets: the button has been held for the hold time.
+ *
+ * A quarter circle forward and A is "2 3 6 a"; a double tap is "a a".
+ *
+ * The symbols must happen one after another.  A gesture only sees the kinds
+ * of symbol it is made of (directions, presses, releases and holds), and of
+ * those only the symbols that some gesture made of the same kinds uses.  So
+ * "a a" is interrupted by a press of b while "b b" is registered, but never
+ * by releases, holds or stick movement.
+ *
+ * A completed gesture is delivered as an EVENT_GESTURE event whose input is
+ * the gesture's handle.  Matching uses the device timestamps of the input, so
+ * inputs that arrive between two updates are not lost.
+ *
+ * \param pattern The symbols to match.
+ * \param window Longest time in milliseconds from the first symbol to the last, or 0 for no limit.
+ * \param gap Longest time in milliseconds between two symbols, or 0 for no limit.
+ * \returns A handle from 0 to 31, or -1 if the pattern is invalid or too many gestures are registered.
+ */
+GAMEPAD_API int GamepadGestureAdd(const char* pattern, unsigned int window, unsigned int gap);
+
+/**
+ * Unregister a gesture.
+ *
+ * \param gesture The handle returned by GamepadGestureAdd.
+ */
+GAMEPAD_API void GamepadGestureRemove(int gesture);
+
+/**
+ * Set how long a button must be held to produce a hold symbol.
+ *
+ * \param hold Hold time in milliseconds (500 by default).
+ */
+GAMEPAD_API void GamepadGestureHoldTime(unsigned int hold);
+
+/**
+ * Feed a symbol into a device's gesture recognizer.
+ *
+ * The library feeds symbols from the input it decodes.  This is for replaying
+ * recorded input and for other sources of symbols.
+ *
+ * \param device The device the symbol belongs to.
+ * \param symbol One of the GAMEPAD_GESTURE_* symbols.
+ * \param time Timestamp of the symbol in milliseconds.
+ */
+GAMEPAD_API void GamepadGestureFeed(GAMEPAD_DEVICE device, int symbol, unsigned int time);
+
+/**
+ * Test if a device has a motion sensor attached.
+ *
+ * On Linux the sensor is the separate input device the driver creates next to
+ * the joystick; it is paired with the device by its identity when either of
+ * them appears.
+ *
+ * \param device The device to check.
+ * \returns GAMEPAD_TRUE if motion samples are being collected.
+ */
+GAMEPAD_API GAMEPAD_BOOL GamepadHasMotion(GAMEPAD_DEVICE device);
+
+/**
+ * Take the oldest motion samples of a device.
+ *
+ * Sensors report at 250 to 1000 Hz, faster than most programs update, so
+ * GamepadUpdate collects every sample into a queue of 1024 per device.  Read
+ * them in batches once per frame.  When the queue is full the oldest samples
+ * are dropped.
+ *
+ * \param device The device to read from.
+ * \param samples Receives the samples, oldest first.
+ * \param max Size of the samples array.
+ * \returns The number of samples returned.
+ */
+GAMEPAD_API unsigned int GamepadMotionRead(GAMEPAD_DEVICE device, GAMEPAD_MOTION* samples, unsigned int max);
+
+/**
+ * Query how many motion samples a device has dropped because they weren't read in time.
+ *
+ * \param device The device to check.
+ * \returns The number of dropped samples since the sensor was attached.
+ */
+GAMEPAD_API unsigned int GamepadMotionDropped(GAMEPAD_DEVICE device);
+
+/**
+ * Measure the gyro bias of a device.
+ *
+ * The average of the next samples is taken as the bias and subtracted from
+ * every sample after them.  The device should be at rest while this runs.
+ *
+ * \param device The device to calibrate.
+ * \param samples Number of samples to average, or 0 to clear the bias.
+ */
+GAMEPAD_API void GamepadMotionCalibrate(GAMEPAD_DEVICE device, unsigned int samples);
+
+/**
+ * Test if a calibration started by GamepadMotionCalibrate is still running.
+ *
+ * \param device The device to check.
+ * \returns GAMEPAD_TRUE until enough samples have been averaged.
+ */
+GAMEPAD_API GAMEPAD_BOOL GamepadMotionCalibrating(GAMEPAD_DEVICE device);
+
+/**
+ * Add up the rotation of a batch of samples.
+ *
+ * This is a plain sum of gyro times dt per axis, good for aiming with small
+ * rotations between frames; it is not an orientation filter.
+ *
+ * \param samples The samples to integrate.
+ * \param count Number of samples.
+ * \param angles The angles in radians around each axis, incremented in place.
+ */
+GAMEPAD_API void GamepadMotionIntegrate(const GAMEPAD_MOTION* samples, unsigned int count, float angles[3]);
+
+/**
+ * Use a descriptor as the motion sensor of a device.
+ *
+ * The descriptor must deliver evdev input_events: accelerometer on ABS_X to
+ * ABS_Z, gyro on ABS_RX to ABS_RZ, optionally MSC_TIMESTAMP, each sample ending
+ * with SYN_REPORT.  A uinput device or one end of a pipe works for testing.
+ * The library takes ownership of the descriptor and closes it on detach.
+ * Linux only.
+ *
+ * \param device The device to attach the sensor to.
+ * \param fd A non-blocking descriptor to read events from.
+ * \returns GAMEPAD_TRUE if the sensor was attached.
+ */
+GAMEPAD_API GAMEPAD_BOOL GamepadMotionAttach(GAMEPAD_DEVICE device, int fd);
+
+/**
+ * Close the motion sensor of a device.
+ *
+ * Samples still queued can be read.
+ *
+ * \param device The device to detach the sensor from.
+ */
+GAMEPAD_API void GamepadMotionDetach(GAMEPAD_DEVICE device);
+
+/**
+ * Query the input latency of a device and mark its inputs as consumed.
+ *
+ * Joystick nodes stamp input with a millisecond clock of their own; its
+ * offset to GamepadClock is estimated from the fastest input seen, so kernel
+ * stamps, and the ages and latencies built on them, can read up to a tick
+ * of the kernel timer low.  A frame loop can call this after GamepadUpdate
+ * and delay or hurry the next frame when newestAge grows.
+ *
+ * \param device The device to query.
+ * \param latency Receives the ages of the inputs applied since the previous
+ * call and the histogram of recent latencies.
+ */
+GAMEPAD_API void GamepadGetLatency(GAMEPAD_DEVICE device, GAMEPAD_LATENCY* latency);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif
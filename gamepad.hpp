@@ -0,0 +1,183 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+/*
+ * Optional header-only C++ interface.
+ *
+ * A pad copies the device state once per frame with GamepadGetSnapshot and
+ * answers every query inline from the copy.  Inputs are template arguments,
+ * so masks are folded at compile time and a check such as
+ *
+ *     pad.anyDown<BUTTON_A, BUTTON_B, BUTTON_X>()
+ *
+ * compiles to a single mask test.
+ */
+
+#if !defined(GAMEPAD_HPP)
+#define GAMEPAD_HPP 1
+
+#include "gamepad.h"
+
+namespace gamepad {
+
+/**
+ * Mask of one or more buttons, computed at compile time.
+ */
+template <GAMEPAD_BUTTON... Buttons>
+constexpr unsigned int buttonMask() {
+	return (0u | ... | GAMEPAD_MASK(Buttons));
+}
+
+/**
+ * Mask of one or more triggers, computed at compile time.
+ */
+template <GAMEPAD_TRIGGER... Triggers>
+constexpr unsigned int triggerMask() {
+	return (0u | ... | GAMEPAD_MASK(Triggers));
+}
+
+/**
+ * Inline queries over a copy of a device's state.
+ */
+class snapshot {
+public:
+	snapshot() : state_() {}
+
+	/** Copy the current state of a device. */
+	void refresh(GAMEPAD_DEVICE device) {
+		GamepadGetSnapshot(device, &state_);
+	}
+
+	/** The raw snapshot. */
+	const GAMEPAD_SNAPSHOT& state() const {
+		return state_;
+	}
+
+	bool connected() const {
+		return state_.connected != GAMEPAD_FALSE;
+	}
+
+	template <GAMEPAD_BUTTON Button>
+	bool down() const {
+		return (state_.buttons & buttonMask<Button>()) != 0;
+	}
+
+	template <GAMEPAD_BUTTON Button>
+	bool triggered() const {
+		return (state_.buttons & ~state_.buttonsLast & buttonMask<Button>()) != 0;
+	}
+
+	template <GAMEPAD_BUTTON Button>
+	bool released() const {
+		return (~state_.buttons & state_.buttonsLast & buttonMask<Button>()) != 0;
+	}
+
+	/** True if any of the buttons is down. */
+	template <GAMEPAD_BUTTON... Buttons>
+	bool anyDown() const {
+		return (state_.buttons & buttonMask<Buttons...>()) != 0;
+	}
+
+	/** True if all of the buttons are down. */
+	template <GAMEPAD_BUTTON... Buttons>
+	bool allDown() const {
+		return (state_.buttons & buttonMask<Buttons...>()) == buttonMask<Buttons...>();
+	}
+
+	/** True if any of the buttons was pressed since the last update. */
+	template <GAMEPAD_BUTTON... Buttons>
+	bool anyTriggered() const {
+		return (state_.buttons & ~state_.buttonsLast & buttonMask<Buttons...>()) != 0;
+	}
+
+	template <GAMEPAD_TRIGGER Trigger>
+	bool triggerDown() const {
+		return (state_.triggers & triggerMask<Trigger>()) != 0;
+	}
+
+	template <GAMEPAD_TRIGGER Trigger>
+	bool triggerTriggered() const {
+		return (state_.triggers & ~state_.triggersLast & triggerMask<Trigger>()) != 0;
+	}
+
+	template <GAMEPAD_TRIGGER Trigger>
+	bool triggerReleased() const {
+		return (~state_.triggers & state_.triggersLast & triggerMask<Trigger>()) != 0;
+	}
+
+	template <GAMEPAD_TRIGGER Trigger>
+	int triggerValue() const {
+		return state_.triggerValue[Trigger];
+	}
+
+	template <GAMEPAD_TRIGGER Trigger>
+	float triggerLength() const {
+		return state_.triggerLength[Trigger];
+	}
+
+	template <GAMEPAD_STICK Stick>
+	int stickX() const {
+		return state_.stickX[Stick];
+	}
+
+	template <GAMEPAD_STICK Stick>
+	int stickY() const {
+		return state_.stickY[Stick];
+	}
+
+	template <GAMEPAD_STICK Stick>
+	float stickNormX() const {
+		return state_.stickNX[Stick];
+	}
+
+	template <GAMEPAD_STICK Stick>
+	float stickNormY() const {
+		return state_.stickNY[Stick];
+	}
+
+	template <GAMEPAD_STICK Stick>
+	float stickLength() const {
+		return state_.stickLength[Stick];
+	}
+
+	template <GAMEPAD_STICK Stick>
+	float stickAngle() const {
+		return state_.stickAngle[Stick];
+	}
+
+	template <GAMEPAD_STICK Stick>
+	GAMEPAD_STICKDIR stickDir() const {
+		return state_.stickDir[Stick];
+	}
+
+	/** True if the stick was pushed into a direction since the last update. */
+	template <GAMEPAD_STICK Stick, GAMEPAD_STICKDIR Dir>
+	bool stickDirTriggered() const {
+		return state_.stickDir[Stick] == Dir && state_.stickDirLast[Stick] != Dir;
+	}
+
+private:
+	GAMEPAD_SNAPSHOT state_;
+};
+
+/**
+ * Snapshot bound to a device at compile time.
+ */
+template <GAMEPAD_DEVICE Device>
+class pad : public snapshot {
+public:
+	static_assert(Device >= GAMEPAD_0 && Device < GAMEPAD_COUNT, "invalid gamepad device");
+
+	/** Copy the current state of the device; call once per frame after GamepadUpdate. */
+	void refresh() {
+		snapshot::refresh(Device);
+	}
+};
+
+} /* namespace gamepad */
+
+#endif
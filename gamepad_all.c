@@ -0,0 +1,23 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+/*
+ * The whole library as a single translation unit, so the compiler sees every
+ * call between subsystems.  Build it with link-time optimization, or add it to
+ * a program's own sources, in place of the individual files.
+ */
+
+#include "gamepad.c"
+#include "gamepad_channel.c"
+#include "gamepad_event.c"
+#include "gamepad_gesture.c"
+#include "gamepad_latency.c"
+#include "gamepad_mapping.c"
+#include "gamepad_motion.c"
+#include "gamepad_rumble.c"
+#include "gamepad_uring.c"
+#include "gamepad_waveform.c"
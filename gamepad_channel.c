@@ -0,0 +1,227 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define GAMEPAD_EXPORT 1
+#include "gamepad_private.h"
+
+#if !defined(GAMEPAD_NO_CHANNELS)
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN 1
+#	include <windows.h>
+#	include <malloc.h>
+#endif
+
+/* A queued event and the sequence number that says who may touch it */
+typedef struct GAMEPAD_CELL GAMEPAD_CELL;
+struct GAMEPAD_CELL {
+	volatile unsigned int sequence;
+	GAMEPAD_EVENT event;
+};
+
+/*
+ * Bounded queue with per-cell sequence numbers.  Any number of threads may
+ * push; one thread pops.  Pops still claim cells with a CAS because a
+ * producer dropping the oldest event competes with the consumer.
+ */
+struct GAMEPAD_CHANNEL {
+	volatile unsigned int head;
+	char pad0[CACHE_LINE - sizeof(unsigned int)];
+	volatile unsigned int tail;
+	char pad1[CACHE_LINE - sizeof(unsigned int)];
+	volatile unsigned int dropped;
+	unsigned int mask;
+	GAMEPAD_OVERFLOW overflow;
+	int subscription;
+	GAMEPAD_CELL* cells;
+};
+
+/* Allocate cache-line aligned memory */
+static void* GamepadChannelAlloc(size_t size) {
+#if defined(_WIN32)
+	return _aligned_malloc(size, CACHE_LINE);
+#else
+	void* p;
+	return posix_memalign(&p, CACHE_LINE, size) == 0 ? p : NULL;
+#endif
+}
+
+static void GamepadChannelFree(void* p) {
+#if defined(_WIN32)
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+/* Claim the oldest cell; returns GAMEPAD_FALSE if the channel is empty */
+static GAMEPAD_BOOL GamepadChannelTake(GAMEPAD_CHANNEL* channel, GAMEPAD_EVENT* event) {
+	GAMEPAD_CELL* cell;
+	unsigned int pos, seq;
+	int diff;
+
+	pos = ATOMIC_LOAD(&channel->tail);
+	for (;;) {
+		cell = &channel->cells[pos & channel->mask];
+		seq = ATOMIC_LOAD(&cell->sequence);
+		diff = (int)(seq - (pos + 1));
+		if (diff == 0) {
+			if (ATOMIC_CAS(&channel->tail, pos, pos + 1)) {
+				break;
+			}
+			pos = ATOMIC_LOAD(&channel->tail);
+		} else if (diff < 0) {
+			return GAMEPAD_FALSE;
+		} else {
+			pos = ATOMIC_LOAD(&channel->tail);
+		}
+	}
+
+	if (event != NULL) {
+		*event = cell->event;
+	}
+	ATOMIC_STORE(&cell->sequence, pos + channel->mask + 1);
+	return GAMEPAD_TRUE;
+}
+
+/* Discard the event at pos if it is still the oldest and fully written */
+static GAMEPAD_BOOL GamepadChannelDrop(GAMEPAD_CHANNEL* channel, unsigned int pos) {
+	GAMEPAD_CELL* cell = &channel->cells[pos & channel->mask];
+
+	if (ATOMIC_LOAD(&cell->sequence) != pos + 1 || !ATOMIC_CAS(&channel->tail, pos, pos + 1)) {
+		return GAMEPAD_FALSE;
+	}
+	ATOMIC_STORE(&cell->sequence, pos + channel->mask + 1);
+	return GAMEPAD_TRUE;
+}
+
+GAMEPAD_BOOL GamepadChannelPush(GAMEPAD_CHANNEL* channel, const GAMEPAD_EVENT* event) {
+	GAMEPAD_CELL* cell;
+	unsigned int pos, seq, tail;
+	int diff;
+
+	pos = ATOMIC_LOAD(&channel->head);
+	for (;;) {
+		cell = &channel->cells[pos & channel->mask];
+		seq = ATOMIC_LOAD(&cell->sequence);
+		diff = (int)(seq - pos);
+		if (diff == 0) {
+			if (ATOMIC_CAS(&channel->head, pos, pos + 1)) {
+				break;
+			}
+			pos = ATOMIC_LOAD(&channel->head);
+		} else if (diff < 0) {
+			/*
+			 * The cell still holds the previous lap.  Unless its event is also
+			 * unclaimed the consumer is just copying it out, so wait for that.
+			 */
+			tail = ATOMIC_LOAD(&channel->tail);
+			if ((int)(pos - tail) > (int)channel->mask) {
+				if (channel->overflow != OVERFLOW_DROP_OLDEST) {
+					ATOMIC_INC(&channel->dropped);
+					return GAMEPAD_FALSE;
+				}
+				/* a consumer or producer that got there first has made room already */
+				if (GamepadChannelDrop(channel, tail)) {
+					ATOMIC_INC(&channel->dropped);
+				}
+			}
+			pos = ATOMIC_LOAD(&channel->head);
+		} else {
+			pos = ATOMIC_LOAD(&channel->head);
+		}
+	}
+
+	cell->event = *event;
+	ATOMIC_STORE(&cell->sequence, pos + 1);
+	return GAMEPAD_TRUE;
+}
+
+GAMEPAD_BOOL GamepadChannelPop(GAMEPAD_CHANNEL* channel, GAMEPAD_EVENT* event) {
+	return GamepadChannelTake(channel, event);
+}
+
+unsigned int GamepadChannelDropped(GAMEPAD_CHANNEL* channel) {
+	return ATOMIC_LOAD(&channel->dropped);
+}
+
+/* Subscription callback publishing into the channel */
+static void GamepadChannelPublish(const GAMEPAD_EVENT* event, void* user) {
+	GamepadChannelPush((GAMEPAD_CHANNEL*)user, event);
+}
+
+GAMEPAD_CHANNEL* GamepadChannelCreate(unsigned int capacity, GAMEPAD_OVERFLOW overflow,
+		unsigned int devices, unsigned int events, unsigned int inputs, int threshold) {
+	GAMEPAD_CHANNEL* channel;
+	unsigned int size = 2;
+	unsigned int i;
+
+	while (size < capacity) {
+		size <<= 1;
+	}
+
+	channel = (GAMEPAD_CHANNEL*)GamepadChannelAlloc(sizeof(GAMEPAD_CHANNEL));
+	if (channel == NULL) {
+		return NULL;
+	}
+	memset(channel, 0, sizeof(*channel));
+
+	channel->cells = (GAMEPAD_CELL*)GamepadChannelAlloc(size * sizeof(GAMEPAD_CELL));
+	if (channel->cells == NULL) {
+		GamepadChannelFree(channel);
+		return NULL;
+	}
+	for (i = 0; i != size; ++i) {
+		channel->cells[i].sequence = i;
+	}
+	channel->mask = size - 1;
+	channel->overflow = overflow;
+
+	channel->subscription = GamepadSubscribe(devices, events, inputs, threshold, GamepadChannelPublish, channel);
+	if (channel->subscription == -1) {
+		GamepadChannelFree(channel->cells);
+		GamepadChannelFree(channel);
+		return NULL;
+	}
+
+	return channel;
+}
+
+void GamepadChannelDestroy(GAMEPAD_CHANNEL* channel) {
+	if (channel != NULL) {
+		GamepadUnsubscribe(channel->subscription);
+		GamepadChannelFree(channel->cells);
+		GamepadChannelFree(channel);
+	}
+}
+
+#else /* defined(GAMEPAD_NO_CHANNELS) */
+
+GAMEPAD_CHANNEL* GamepadChannelCreate(unsigned int capacity, GAMEPAD_OVERFLOW overflow,
+		unsigned int devices, unsigned int events, unsigned int inputs, int threshold) {
+	return NULL;
+}
+
+void GamepadChannelDestroy(GAMEPAD_CHANNEL* channel) {
+}
+
+GAMEPAD_BOOL GamepadChannelPush(GAMEPAD_CHANNEL* channel, const GAMEPAD_EVENT* event) {
+	return GAMEPAD_FALSE;
+}
+
+GAMEPAD_BOOL GamepadChannelPop(GAMEPAD_CHANNEL* channel, GAMEPAD_EVENT* event) {
+	return GAMEPAD_FALSE;
+}
+
+unsigned int GamepadChannelDropped(GAMEPAD_CHANNEL* channel) {
+	return 0;
+}
+
+#endif
@@ -0,0 +1,324 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+/*
+ * Optional C++20 coroutine interface.
+ *
+ * Awaitables suspend a coroutine until a matching event arrives:
+ *
+ *     co_await gamepad::deviceConnected();
+ *     GAMEPAD_EVENT press = co_await gamepad::nextButton(GAMEPAD_0, BUTTON_A);
+ *
+ * Waiting coroutines are resumed by gamepad::update(), which must be called
+ * instead of GamepadUpdate, or by gamepad::wait(), which sleeps until there is
+ * input.  Both run on the calling thread.  An awaiter lives in the awaiting
+ * coroutine's frame, so awaiting never allocates.
+ */
+
+#if !defined(GAMEPAD_CORO_HPP)
+#define GAMEPAD_CORO_HPP 1
+
+#include <coroutine>
+
+#include "gamepad.h"
+
+namespace gamepad {
+
+namespace detail {
+
+/* A suspended coroutine and the event it waits for */
+struct waiter {
+	waiter* next = nullptr;
+	std::coroutine_handle<> handle;
+	unsigned int devices = 0;
+	unsigned int events = 0;
+	unsigned int inputs = 0;
+	GAMEPAD_EVENT event = {};
+	bool queued = false;
+
+	bool matches(const GAMEPAD_EVENT& e) const {
+		return (devices & GAMEPAD_MASK(e.device)) != 0 &&
+			(events & GAMEPAD_MASK(e.type)) != 0 &&
+			(e.type == EVENT_CONNECTED || e.type == EVENT_DISCONNECTED || (inputs & GAMEPAD_MASK(e.input)) != 0);
+	}
+};
+
+/* Waiters in arrival order; pending ones wait for an event, ready ones for resumption */
+class scheduler {
+public:
+	static scheduler& instance() {
+		static scheduler s;
+		return s;
+	}
+
+	void add(waiter* w) {
+		append(pending_, w);
+		resubscribe();
+	}
+
+	void remove(waiter* w) {
+		if (unlink(pending_, w)) {
+			resubscribe();
+		} else {
+			unlink(ready_, w);
+		}
+	}
+
+	/*
+	 * Resume every coroutine whose event arrived.  Each is unlinked just before
+	 * it runs, so one that destroys a coroutine still in the list unlinks it.
+	 */
+	void resume() {
+		while (ready_ != nullptr) {
+			waiter* w = ready_;
+			ready_ = w->next;
+			w->next = nullptr;
+			w->queued = false;
+			w->handle.resume();
+		}
+	}
+
+private:
+	waiter* pending_ = nullptr;
+	waiter* ready_ = nullptr;
+	int subscription_ = -1;
+
+	static void append(waiter*& list, waiter* w) {
+		waiter** p = &list;
+		while (*p != nullptr) {
+			p = &(*p)->next;
+		}
+		w->next = nullptr;
+		w->queued = true;
+		*p = w;
+	}
+
+	static bool unlink(waiter*& list, waiter* w) {
+		for (waiter** p = &list; *p != nullptr; p = &(*p)->next) {
+			if (*p == w) {
+				*p = w->next;
+				w->next = nullptr;
+				w->queued = false;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/* Only subscribe to what somebody is waiting for */
+	void resubscribe() {
+		unsigned int devices = 0, events = 0, inputs = 0;
+		for (waiter* w = pending_; w != nullptr; w = w->next) {
+			devices |= w->devices;
+			events |= w->events;
+			inputs |= w->inputs;
+		}
+
+		if (subscription_ != -1) {
+			GamepadUnsubscribe(subscription_);
+			subscription_ = -1;
+		}
+		if (pending_ != nullptr) {
+			subscription_ = GamepadSubscribe(devices, events, inputs, 0, &scheduler::dispatch, this);
+		}
+	}
+
+	static void dispatch(const GAMEPAD_EVENT* event, void* user) {
+		scheduler* self = static_cast<scheduler*>(user);
+		waiter** p = &self->pending_;
+		bool changed = false;
+
+		while (*p != nullptr) {
+			waiter* w = *p;
+			if (w->matches(*event)) {
+				*p = w->next;
+				w->event = *event;
+				append(self->ready_, w);
+				changed = true;
+			} else {
+				p = &w->next;
+			}
+		}
+
+		if (changed) {
+			self->resubscribe();
+		}
+	}
+};
+
+/* Awaitable for the next event matching a filter */
+class event_awaiter {
+public:
+	event_awaiter(unsigned int devices, unsigned int events, unsigned int inputs, bool ready = false) : ready_(ready) {
+		waiter_.devices = devices;
+		waiter_.events = events;
+		waiter_.inputs = inputs;
+	}
+
+	event_awaiter(const event_awaiter&) = delete;
+	event_awaiter& operator=(const event_awaiter&) = delete;
+
+	/* a coroutine destroyed while suspended must not stay queued */
+	~event_awaiter() {
+		if (waiter_.queued) {
+			scheduler::instance().remove(&waiter_);
+		}
+	}
+
+	bool await_ready() const noexcept {
+		return ready_;
+	}
+
+	void await_suspend(std::coroutine_handle<> handle) {
+		waiter_.handle = handle;
+		scheduler::instance().add(&waiter_);
+	}
+
+	GAMEPAD_EVENT await_resume() const noexcept {
+		return waiter_.event;
+	}
+
+protected:
+	waiter waiter_;
+	bool ready_;
+};
+
+/* Awaitable resolving to the device of a connection event */
+class device_awaiter : public event_awaiter {
+public:
+	device_awaiter(unsigned int devices, GAMEPAD_EVENT_TYPE type, GAMEPAD_DEVICE ready) :
+		event_awaiter(devices, GAMEPAD_MASK(type), GAMEPAD_MASK_ALL, ready != GAMEPAD_COUNT) {
+		waiter_.event.device = ready;
+	}
+
+	GAMEPAD_DEVICE await_resume() const noexcept {
+		return waiter_.event.device;
+	}
+};
+
+/* First device in a mask that is (or isn't) connected, or GAMEPAD_COUNT */
+inline GAMEPAD_DEVICE findDevice(unsigned int devices, GAMEPAD_BOOL connected) {
+	for (int i = 0; i != GAMEPAD_COUNT; ++i) {
+		if ((devices & GAMEPAD_MASK(i)) != 0 && GamepadIsConnected(static_cast<GAMEPAD_DEVICE>(i)) == connected) {
+			return static_cast<GAMEPAD_DEVICE>(i);
+		}
+	}
+	return GAMEPAD_COUNT;
+}
+
+} /* namespace detail */
+
+/**
+ * Wait for a button to be pressed.
+ *
+ * \returns The EVENT_BUTTON_DOWN event.
+ */
+inline detail::event_awaiter nextButton(GAMEPAD_DEVICE device, GAMEPAD_BUTTON button) {
+	return detail::event_awaiter(GAMEPAD_MASK(device), GAMEPAD_MASK(EVENT_BUTTON_DOWN), GAMEPAD_MASK(button));
+}
+
+/**
+ * Wait for any button on a device to be pressed.
+ *
+ * \returns The EVENT_BUTTON_DOWN event.
+ */
+inline detail::event_awaiter anyButton(GAMEPAD_DEVICE device) {
+	return detail::event_awaiter(GAMEPAD_MASK(device), GAMEPAD_MASK(EVENT_BUTTON_DOWN), GAMEPAD_MASK_ALL);
+}
+
+/**
+ * Wait for a button to be released.
+ *
+ * \returns The EVENT_BUTTON_UP event.
+ */
+inline detail::event_awaiter buttonReleased(GAMEPAD_DEVICE device, GAMEPAD_BUTTON button) {
+	return detail::event_awaiter(GAMEPAD_MASK(device), GAMEPAD_MASK(EVENT_BUTTON_UP), GAMEPAD_MASK(button));
+}
+
+/**
+ * Wait for a trigger to be pressed past its deadzone.
+ *
+ * \returns The EVENT_TRIGGER_DOWN event.
+ */
+inline detail::event_awaiter nextTrigger(GAMEPAD_DEVICE device, GAMEPAD_TRIGGER trigger) {
+	return detail::event_awaiter(GAMEPAD_MASK(device), GAMEPAD_MASK(EVENT_TRIGGER_DOWN), GAMEPAD_MASK(trigger));
+}
+
+/**
+ * Wait for a stick to be pushed in a new direction.
+ *
+ * \returns The EVENT_STICK_DIR event; its value holds the direction.
+ */
+inline detail::event_awaiter nextStickDir(GAMEPAD_DEVICE device, GAMEPAD_STICK stick) {
+	return detail::event_awaiter(GAMEPAD_MASK(device), GAMEPAD_MASK(EVENT_STICK_DIR), GAMEPAD_MASK(stick));
+}
+
+/**
+ * Wait for a gesture registered with GamepadGestureAdd to be performed.
+ *
+ * \returns The EVENT_GESTURE event.
+ */
+inline detail::event_awaiter nextGesture(GAMEPAD_DEVICE device, int gesture) {
+	return detail::event_awaiter(GAMEPAD_MASK(device), GAMEPAD_MASK(EVENT_GESTURE), GAMEPAD_MASK(gesture));
+}
+
+/**
+ * Wait for the next event matching a filter, as for GamepadSubscribe.
+ *
+ * \returns The event.
+ */
+inline detail::event_awaiter nextEvent(unsigned int devices, unsigned int events, unsigned int inputs) {
+	return detail::event_awaiter(devices, events, inputs);
+}
+
+/**
+ * Wait until one of the given devices is connected.
+ *
+ * Completes immediately if one already is.
+ *
+ * \returns The connected device.
+ */
+inline detail::device_awaiter deviceConnected(unsigned int devices = GAMEPAD_MASK_ALL) {
+	return detail::device_awaiter(devices, EVENT_CONNECTED, detail::findDevice(devices, GAMEPAD_TRUE));
+}
+
+/**
+ * Wait until a device is disconnected.
+ *
+ * Completes immediately if it already is.
+ *
+ * \returns The disconnected device.
+ */
+inline detail::device_awaiter deviceDisconnected(GAMEPAD_DEVICE device) {
+	return detail::device_awaiter(GAMEPAD_MASK(device), EVENT_DISCONNECTED, detail::findDevice(GAMEPAD_MASK(device), GAMEPAD_FALSE));
+}
+
+/**
+ * Update the gamepads and resume every coroutine whose event arrived.
+ *
+ * Use this in place of GamepadUpdate.
+ */
+inline void update() {
+	GamepadUpdate();
+	detail::scheduler::instance().resume();
+}
+
+/**
+ * Sleep until there is input, then update as gamepad::update() does.
+ *
+ * \param timeout Maximum time to wait in milliseconds, or -1 to wait forever.
+ * \returns true if there was input, false if the timeout expired.
+ */
+inline bool wait(int timeout = -1) {
+	bool input = GamepadWait(timeout) != GAMEPAD_FALSE;
+	update();
+	return input;
+}
+
+} /* namespace gamepad */
+
+#endif
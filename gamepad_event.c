@@ -0,0 +1,184 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+#include <string.h>
+
+#define GAMEPAD_EXPORT 1
+#include "gamepad_private.h"
+
+#if !defined(GAMEPAD_NO_EVENTS)
+
+/* Maximum number of simultaneous subscriptions */
+#define SUBSCRIPTION_COUNT	32
+
+/* A registered callback and its filters */
+typedef struct GAMEPAD_SUBSCRIPTION GAMEPAD_SUBSCRIPTION;
+struct GAMEPAD_SUBSCRIPTION {
+	GAMEPAD_CALLBACK callback;
+	void* user;
+	unsigned int devices, events, inputs;
+	int threshold;
+	int lastX[GAMEPAD_COUNT][STICK_COUNT];
+	int lastY[GAMEPAD_COUNT][STICK_COUNT];
+};
+
+static GAMEPAD_SUBSCRIPTION SUBSCRIPTIONS[SUBSCRIPTION_COUNT];
+
+/* Union of the subscribed inputs per device and event type */
+unsigned int GAMEPAD_EVENT_INPUTS[GAMEPAD_COUNT][EVENT_COUNT];
+
+/* Recompute the filter the decode path checks */
+static void GamepadEventRebuild(void) {
+	int i, d, e;
+
+	memset(GAMEPAD_EVENT_INPUTS, 0, sizeof(GAMEPAD_EVENT_INPUTS));
+
+	for (i = 0; i != SUBSCRIPTION_COUNT; ++i) {
+		if (SUBSCRIPTIONS[i].callback == NULL) {
+			continue;
+		}
+		for (d = 0; d != GAMEPAD_COUNT; ++d) {
+			if ((SUBSCRIPTIONS[i].devices & GAMEPAD_MASK(d)) == 0) {
+				continue;
+			}
+			for (e = 0; e != EVENT_COUNT; ++e) {
+				if ((SUBSCRIPTIONS[i].events & GAMEPAD_MASK(e)) == 0) {
+					continue;
+				}
+				/* connection events have no input */
+				if (e == EVENT_CONNECTED || e == EVENT_DISCONNECTED) {
+					GAMEPAD_EVENT_INPUTS[d][e] = GAMEPAD_MASK_ALL;
+				} else {
+					GAMEPAD_EVENT_INPUTS[d][e] |= SUBSCRIPTIONS[i].inputs;
+				}
+			}
+		}
+	}
+}
+
+int GamepadSubscribe(unsigned int devices, unsigned int events, unsigned int inputs, int threshold, GAMEPAD_CALLBACK callback, void* user) {
+	int i;
+
+	if (callback == NULL) {
+		return -1;
+	}
+
+	for (i = 0; i != SUBSCRIPTION_COUNT; ++i) {
+		if (SUBSCRIPTIONS[i].callback == NULL) {
+			memset(&SUBSCRIPTIONS[i], 0, sizeof(SUBSCRIPTIONS[i]));
+			SUBSCRIPTIONS[i].callback = callback;
+			SUBSCRIPTIONS[i].user = user;
+			SUBSCRIPTIONS[i].devices = devices;
+			SUBSCRIPTIONS[i].events = events;
+			SUBSCRIPTIONS[i].inputs = inputs;
+			SUBSCRIPTIONS[i].threshold = threshold;
+			GamepadEventRebuild();
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void GamepadUnsubscribe(int subscription) {
+	if (subscription >= 0 && subscription < SUBSCRIPTION_COUNT) {
+		SUBSCRIPTIONS[subscription].callback = NULL;
+		GamepadEventRebuild();
+	}
+}
+
+/* Deliver an event to every matching subscription */
+void GamepadEmit(const GAMEPAD_EVENT* event) {
+	GAMEPAD_SUBSCRIPTION* sub;
+	int i;
+
+	for (i = 0; i != SUBSCRIPTION_COUNT; ++i) {
+		sub = &SUBSCRIPTIONS[i];
+		if (sub->callback == NULL ||
+				(sub->devices & GAMEPAD_MASK(event->device)) == 0 ||
+				(sub->events & GAMEPAD_MASK(event->type)) == 0) {
+			continue;
+		}
+
+		if (event->type != EVENT_CONNECTED && event->type != EVENT_DISCONNECTED &&
+				(sub->inputs & GAMEPAD_MASK(event->input)) == 0) {
+			continue;
+		}
+
+		if (event->type == EVENT_AXIS) {
+			int* lastX = &sub->lastX[event->device][event->input];
+			int* lastY = &sub->lastY[event->device][event->input];
+			if (event->x - *lastX <= sub->threshold && *lastX - event->x <= sub->threshold &&
+					event->y - *lastY <= sub->threshold && *lastY - event->y <= sub->threshold) {
+				continue;
+			}
+			*lastX = event->x;
+			*lastY = event->y;
+		}
+
+		sub->callback(event, sub->user);
+	}
+}
+
+void GamepadEmitEvent(GAMEPAD_DEVICE device, GAMEPAD_EVENT_TYPE type, int input, int value, unsigned int time) {
+	GAMEPAD_EVENT event;
+
+	if ((GAMEPAD_EVENT_INPUTS[device][type] & GAMEPAD_MASK(input)) == 0) {
+		return;
+	}
+
+	event.type = type;
+	event.device = device;
+	event.input = input;
+	event.value = value;
+	event.x = event.y = 0;
+	event.time = time;
+	GamepadLatencyStamp(&event);
+	GamepadEmit(&event);
+}
+
+void GamepadEmitButtons(GAMEPAD_DEVICE device, int before, int after, unsigned int time) {
+	int changed = (before ^ after) &
+		(int)(GAMEPAD_EVENT_INPUTS[device][EVENT_BUTTON_DOWN] | GAMEPAD_EVENT_INPUTS[device][EVENT_BUTTON_UP]);
+	int i;
+
+	for (i = 0; changed != 0 && i != BUTTON_COUNT; ++i) {
+		if (changed & BUTTON_TO_FLAG(i)) {
+			GamepadEmitEvent(device, (after & BUTTON_TO_FLAG(i)) ? EVENT_BUTTON_DOWN : EVENT_BUTTON_UP, i, 0, time);
+			changed &= ~BUTTON_TO_FLAG(i);
+		}
+	}
+}
+
+void GamepadEmitAxis(GAMEPAD_DEVICE device, GAMEPAD_STICK stick, int x, int y, unsigned int time) {
+	GAMEPAD_EVENT event;
+
+	if ((GAMEPAD_EVENT_INPUTS[device][EVENT_AXIS] & GAMEPAD_MASK(stick)) == 0) {
+		return;
+	}
+
+	event.type = EVENT_AXIS;
+	event.device = device;
+	event.input = stick;
+	event.value = 0;
+	event.x = x;
+	event.y = y;
+	event.time = time;
+	GamepadLatencyStamp(&event);
+	GamepadEmit(&event);
+}
+
+#else /* defined(GAMEPAD_NO_EVENTS) */
+
+int GamepadSubscribe(unsigned int devices, unsigned int events, unsigned int inputs, int threshold, GAMEPAD_CALLBACK callback, void* user) {
+	return -1;
+}
+
+void GamepadUnsubscribe(int subscription) {
+}
+
+#endif
@@ -0,0 +1,452 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+#include <string.h>
+
+#define GAMEPAD_EXPORT 1
+#include "gamepad_private.h"
+
+#if !defined(GAMEPAD_NO_GESTURES)
+
+/* Limits; a gesture handle must fit in an input mask */
+#define GESTURE_COUNT		32
+#define GESTURE_MAX_LENGTH	16
+#define GESTURE_SYMBOLS		64
+#define GESTURE_GROUPS		16
+#define GESTURE_STATES		(GESTURE_COUNT * GESTURE_MAX_LENGTH + GESTURE_GROUPS)
+
+/* Kind of a symbol: direction, press, release or hold */
+#define GESTURE_KIND(symbol)	((symbol) >> 4)
+
+/* A registered pattern */
+typedef struct GESTURE_PATTERN GESTURE_PATTERN;
+struct GESTURE_PATTERN {
+	unsigned char symbol[GESTURE_MAX_LENGTH];
+	int length;
+	unsigned int kinds;		/* one bit per GESTURE_KIND it uses; also its group */
+	unsigned int window;
+	unsigned int gap;
+};
+
+/* Where one device is in the automaton of one group */
+typedef struct GESTURE_TRACK GESTURE_TRACK;
+struct GESTURE_TRACK {
+	unsigned int state;
+	unsigned int count;
+	unsigned int time[GESTURE_MAX_LENGTH];	/* ring of the latest symbol times */
+};
+
+/* Recognizer state of one device */
+typedef struct GESTURE_DEVICE GESTURE_DEVICE;
+struct GESTURE_DEVICE {
+	GESTURE_TRACK track[GESTURE_GROUPS];
+	int buttons;
+	int dir;
+	unsigned long long pressed[BUTTON_COUNT];	/* GamepadTimeMicros of each press, 0 once held */
+	unsigned int pressTime[BUTTON_COUNT];
+};
+
+static GESTURE_PATTERN PATTERNS[GESTURE_COUNT];
+static GESTURE_DEVICE DEVICES[GAMEPAD_COUNT];
+static unsigned int HOLD_TIME = 500;
+
+/*
+ * Aho-Corasick automata with the failure links folded into a full transition
+ * table, so each symbol costs one lookup.  MATCHES holds the patterns ending
+ * at a state, including those ending at its suffixes.
+ *
+ * Patterns are grouped by the kinds of symbol they use, and each group gets
+ * its own automaton in the table, starting at ROOT.  A group only sees the
+ * symbols its patterns use, so "a a" isn't broken by the release another
+ * pattern needs, or by the stick moving for a quarter circle.
+ */
+static unsigned short NEXT[GESTURE_STATES][GESTURE_SYMBOLS];
+static unsigned int MATCHES[GESTURE_STATES];
+static unsigned short ROOT[GESTURE_GROUPS];
+static unsigned int REGISTERED = 0;
+static GAMEPAD_BOOL DIRTY = GAMEPAD_FALSE;
+
+/* Groups that use each symbol */
+static unsigned short SYMBOL_GROUPS[GESTURE_SYMBOLS];
+
+/* Symbols some pattern uses, and which kinds of symbol the decode path must produce */
+static unsigned long long USED = 0;
+unsigned int GAMEPAD_GESTURE_ACTIVE = 0;
+
+/* Button names as in mapping strings */
+typedef struct GESTURE_NAME GESTURE_NAME;
+struct GESTURE_NAME {
+	const char* name;
+	int button;
+};
+
+static const GESTURE_NAME GESTURE_NAMES[] = {
+	{ "a",				BUTTON_A },
+	{ "b",				BUTTON_B },
+	{ "x",				BUTTON_X },
+	{ "y",				BUTTON_Y },
+	{ "back",			BUTTON_BACK },
+	{ "guide",			BUTTON_GUIDE },
+	{ "start",			BUTTON_START },
+	{ "leftstick",		BUTTON_LEFT_THUMB },
+	{ "rightstick",		BUTTON_RIGHT_THUMB },
+	{ "leftshoulder",	BUTTON_LEFT_SHOULDER },
+	{ "rightshoulder",	BUTTON_RIGHT_SHOULDER },
+	{ "dpup",			BUTTON_DPAD_UP },
+	{ "dpdown",			BUTTON_DPAD_DOWN },
+	{ "dpleft",			BUTTON_DPAD_LEFT },
+	{ "dpright",		BUTTON_DPAD_RIGHT },
+	{ NULL, -1 }
+};
+
+/* Parse a single symbol token; returns -1 if it is invalid */
+static int GamepadGestureParseSymbol(const char* text, int len) {
+	int i, kind = GAMEPAD_GESTURE_PRESS(0);
+
+	if (len == 1 && text[0] >= '1' && text[0] <= '9') {
+		return GAMEPAD_GESTURE_DIR(text[0] - '0');
+	}
+
+	if (len > 2 && text[0] == '[' && text[len - 1] == ']') {
+		kind = GAMEPAD_GESTURE_HOLD(0);
+		++text;
+		len -= 2;
+	} else if (len > 1 && (text[0] == '+' || text[0] == '-')) {
+		kind = text[0] == '-' ? GAMEPAD_GESTURE_RELEASE(0) : GAMEPAD_GESTURE_PRESS(0);
+		++text;
+		--len;
+	}
+
+	for (i = 0; GESTURE_NAMES[i].name != NULL; ++i) {
+		if ((int)strlen(GESTURE_NAMES[i].name) == len && strncmp(GESTURE_NAMES[i].name, text, len) == 0) {
+			return kind + GESTURE_NAMES[i].button;
+		}
+	}
+	return -1;
+}
+
+/* Numpad direction of the d-pad, or of the left stick if the d-pad is neutral */
+static int GamepadGestureDir(int buttons, int x, int y) {
+	int h, v, ax, ay;
+
+	h = ((buttons & BUTTON_TO_FLAG(BUTTON_DPAD_RIGHT)) != 0) - ((buttons & BUTTON_TO_FLAG(BUTTON_DPAD_LEFT)) != 0);
+	v = ((buttons & BUTTON_TO_FLAG(BUTTON_DPAD_UP)) != 0) - ((buttons & BUTTON_TO_FLAG(BUTTON_DPAD_DOWN)) != 0);
+
+	if (h == 0 && v == 0 && x * x + y * y > GAMEPAD_DEADZONE_LEFT_STICK * GAMEPAD_DEADZONE_LEFT_STICK) {
+		/* eight sectors; a diagonal once the minor axis passes 0.4 of the major */
+		ax = x < 0 ? -x : x;
+		ay = y < 0 ? -y : y;
+		h = ax * 5 > ay * 2 ? (x > 0 ? 1 : -1) : 0;
+		v = ay * 5 > ax * 2 ? (y > 0 ? 1 : -1) : 0;
+	}
+
+	return 5 + h + 3 * v;
+}
+
+/*
+ * The decode path doesn't feed symbols nobody listens for, so the edge state
+ * of a newly needed kind is stale; take it from the device state instead of
+ * reporting presses and releases that happened before the pattern existed.
+ */
+static void GamepadGestureSync(unsigned int kinds) {
+	GESTURE_DEVICE* dev;
+	int i, b, buttons, x, y;
+
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		dev = &DEVICES[i];
+		buttons = 0;
+		for (b = 0; b != BUTTON_COUNT; ++b) {
+			if (GamepadButtonDown((GAMEPAD_DEVICE)i, (GAMEPAD_BUTTON)b)) {
+				buttons |= BUTTON_TO_FLAG(b);
+			}
+		}
+		if (kinds & GESTURE_ACTIVE_BUTTONS) {
+			/* buttons already down never started a hold */
+			dev->buttons = buttons;
+			memset(dev->pressed, 0, sizeof(dev->pressed));
+		}
+		if (kinds & GESTURE_ACTIVE_DIRS) {
+			GamepadStickXY((GAMEPAD_DEVICE)i, STICK_LEFT, &x, &y);
+			dev->dir = GamepadGestureDir(buttons, x, y);
+		}
+	}
+}
+
+/* Rebuild the automata from the registered patterns */
+static void GamepadGestureBuild(void) {
+	unsigned short fail[GESTURE_STATES];
+	unsigned short queue[GESTURE_STATES];
+	unsigned int states = 0, head, tail;
+	unsigned int i, g, s, root, state, next;
+	unsigned int previous = GAMEPAD_GESTURE_ACTIVE;
+	int j, p;
+
+	memset(NEXT, 0, sizeof(NEXT));
+	memset(MATCHES, 0, sizeof(MATCHES));
+	memset(ROOT, 0, sizeof(ROOT));
+	memset(SYMBOL_GROUPS, 0, sizeof(SYMBOL_GROUPS));
+	USED = 0;
+	GAMEPAD_GESTURE_ACTIVE = 0;
+
+	for (g = 1; g != GESTURE_GROUPS; ++g) {
+		/* trie; 0 in NEXT means "no edge" while building, as no edge leads back to a root */
+		root = states;
+		for (p = 0; p != GESTURE_COUNT; ++p) {
+			if ((REGISTERED & GAMEPAD_MASK(p)) == 0 || PATTERNS[p].kinds != g) {
+				continue;
+			}
+			if (root == states) {
+				++states;
+			}
+			state = root;
+			for (j = 0; j != PATTERNS[p].length; ++j) {
+				s = PATTERNS[p].symbol[j];
+				SYMBOL_GROUPS[s] |= (unsigned short)GAMEPAD_MASK(g);
+				USED |= 1ull << s;
+				if (NEXT[state][s] == 0) {
+					NEXT[state][s] = (unsigned short)states++;
+				}
+				state = NEXT[state][s];
+			}
+			MATCHES[state] |= GAMEPAD_MASK(p);
+		}
+		if (root == states) {
+			continue;
+		}
+		ROOT[g] = (unsigned short)root;
+
+		/* breadth-first: missing edges take the failure state's edge */
+		head = tail = 0;
+		for (s = 0; s != GESTURE_SYMBOLS; ++s) {
+			if (NEXT[root][s] != 0) {
+				fail[NEXT[root][s]] = (unsigned short)root;
+				queue[tail++] = NEXT[root][s];
+			} else {
+				NEXT[root][s] = (unsigned short)root;
+			}
+		}
+		while (head != tail) {
+			state = queue[head++];
+			MATCHES[state] |= MATCHES[fail[state]];
+			for (s = 0; s != GESTURE_SYMBOLS; ++s) {
+				next = NEXT[state][s];
+				if (next != 0) {
+					fail[next] = NEXT[fail[state]][s];
+					queue[tail++] = (unsigned short)next;
+				} else {
+					NEXT[state][s] = NEXT[fail[state]][s];
+				}
+			}
+		}
+	}
+
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		for (g = 0; g != GESTURE_GROUPS; ++g) {
+			DEVICES[i].track[g].state = ROOT[g];
+		}
+	}
+
+	/* the decode path only tracks what somebody listens for */
+	if (USED & 0x1ffull) {
+		GAMEPAD_GESTURE_ACTIVE |= GESTURE_ACTIVE_DIRS;
+	}
+	if (USED & 0xffffffff0000ull) {
+		GAMEPAD_GESTURE_ACTIVE |= GESTURE_ACTIVE_BUTTONS;
+	}
+	if (USED & 0xffff000000000000ull) {
+		GAMEPAD_GESTURE_ACTIVE |= GESTURE_ACTIVE_HOLDS|GESTURE_ACTIVE_BUTTONS;
+	}
+	GamepadGestureSync(GAMEPAD_GESTURE_ACTIVE & ~previous);
+
+	DIRTY = GAMEPAD_FALSE;
+}
+
+int GamepadGestureAdd(const char* pattern, unsigned int window, unsigned int gap) {
+	GESTURE_PATTERN parsed;
+	const char* p = pattern;
+	const char* token;
+	int i, symbol;
+
+	memset(&parsed, 0, sizeof(parsed));
+	parsed.window = window;
+	parsed.gap = gap;
+
+	for (;;) {
+		while (*p == ' ' || *p == '\t') {
+			++p;
+		}
+		if (*p == '\0') {
+			break;
+		}
+		token = p;
+		while (*p != ' ' && *p != '\t' && *p != '\0') {
+			++p;
+		}
+		symbol = GamepadGestureParseSymbol(token, (int)(p - token));
+		if (symbol < 0 || parsed.length == GESTURE_MAX_LENGTH) {
+			return -1;
+		}
+		parsed.symbol[parsed.length++] = (unsigned char)symbol;
+		parsed.kinds |= GAMEPAD_MASK(GESTURE_KIND(symbol));
+	}
+
+	if (parsed.length == 0) {
+		return -1;
+	}
+
+	for (i = 0; i != GESTURE_COUNT; ++i) {
+		if ((REGISTERED & GAMEPAD_MASK(i)) == 0) {
+			PATTERNS[i] = parsed;
+			REGISTERED |= GAMEPAD_MASK(i);
+			GamepadGestureBuild();
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void GamepadGestureRemove(int gesture) {
+	if (gesture >= 0 && gesture < GESTURE_COUNT && (REGISTERED & GAMEPAD_MASK(gesture)) != 0) {
+		REGISTERED &= ~GAMEPAD_MASK(gesture);
+		/* may be called from an EVENT_GESTURE callback, so don't rebuild under the matcher */
+		DIRTY = GAMEPAD_TRUE;
+	}
+}
+
+void GamepadGestureHoldTime(unsigned int hold) {
+	HOLD_TIME = hold;
+}
+
+/* Check the timing of a pattern that just matched */
+static GAMEPAD_BOOL GamepadGestureTimely(const GESTURE_TRACK* track, const GESTURE_PATTERN* pattern) {
+	unsigned int last = track->count - 1;
+	unsigned int first = track->count - (unsigned int)pattern->length;
+	unsigned int i;
+
+	if (pattern->window != 0 &&
+			track->time[last % GESTURE_MAX_LENGTH] - track->time[first % GESTURE_MAX_LENGTH] > pattern->window) {
+		return GAMEPAD_FALSE;
+	}
+	if (pattern->gap != 0) {
+		for (i = first + 1; i != track->count; ++i) {
+			if (track->time[i % GESTURE_MAX_LENGTH] - track->time[(i - 1) % GESTURE_MAX_LENGTH] > pattern->gap) {
+				return GAMEPAD_FALSE;
+			}
+		}
+	}
+	return GAMEPAD_TRUE;
+}
+
+void GamepadGestureFeed(GAMEPAD_DEVICE device, int symbol, unsigned int time) {
+	GESTURE_DEVICE* dev = &DEVICES[device];
+	GESTURE_TRACK* track;
+	unsigned int groups, matches, done = 0;
+	int g, p;
+
+	if (DIRTY) {
+		GamepadGestureBuild();
+	}
+	if (symbol < 0 || symbol >= GESTURE_SYMBOLS || (USED & (1ull << symbol)) == 0) {
+		return;
+	}
+
+	for (groups = SYMBOL_GROUPS[symbol]; groups != 0; groups &= groups - 1) {
+		for (g = 1; (groups & GAMEPAD_MASK(g)) == 0; ++g) {
+		}
+		track = &dev->track[g];
+		track->time[track->count++ % GESTURE_MAX_LENGTH] = time;
+		track->state = NEXT[track->state][symbol];
+
+		for (matches = MATCHES[track->state]; matches != 0; matches &= matches - 1) {
+			for (p = 0; (matches & GAMEPAD_MASK(p)) == 0; ++p) {
+			}
+			if (GamepadGestureTimely(track, &PATTERNS[p])) {
+				done |= GAMEPAD_MASK(p);
+			}
+		}
+	}
+
+	/* in handle order, and after the matching, so callbacks may add or remove gestures */
+	for (p = 0; done != 0; ++p) {
+		if (done & GAMEPAD_MASK(p)) {
+			done &= ~GAMEPAD_MASK(p);
+			GamepadEmitEvent(device, EVENT_GESTURE, p, 0, time);
+		}
+	}
+}
+
+void GamepadGestureInput(GAMEPAD_DEVICE device, int buttons, int x, int y, unsigned int time) {
+	GESTURE_DEVICE* dev = &DEVICES[device];
+	int changed, dir, i;
+
+	if (GAMEPAD_GESTURE_ACTIVE & GESTURE_ACTIVE_DIRS) {
+		dir = GamepadGestureDir(buttons, x, y);
+		if (dir != dev->dir) {
+			dev->dir = dir;
+			GamepadGestureFeed(device, GAMEPAD_GESTURE_DIR(dir), time);
+		}
+	}
+
+	if (GAMEPAD_GESTURE_ACTIVE & GESTURE_ACTIVE_BUTTONS) {
+		changed = buttons ^ dev->buttons;
+		dev->buttons = buttons;
+		for (i = 0; changed != 0; ++i) {
+			if ((changed & BUTTON_TO_FLAG(i)) == 0) {
+				continue;
+			}
+			changed &= ~BUTTON_TO_FLAG(i);
+			if (buttons & BUTTON_TO_FLAG(i)) {
+				dev->pressed[i] = GamepadTimeMicros();
+				dev->pressTime[i] = time;
+				GamepadGestureFeed(device, GAMEPAD_GESTURE_PRESS(i), time);
+			} else {
+				dev->pressed[i] = 0;
+				GamepadGestureFeed(device, GAMEPAD_GESTURE_RELEASE(i), time);
+			}
+		}
+	}
+}
+
+void GamepadGestureTick(GAMEPAD_DEVICE device, unsigned long long now) {
+	GESTURE_DEVICE* dev = &DEVICES[device];
+	int i;
+
+	for (i = 0; i != BUTTON_COUNT; ++i) {
+		if (dev->pressed[i] != 0 && now - dev->pressed[i] >= (unsigned long long)HOLD_TIME * 1000) {
+			dev->pressed[i] = 0;
+			GamepadGestureFeed(device, GAMEPAD_GESTURE_HOLD(i), dev->pressTime[i] + HOLD_TIME);
+		}
+	}
+}
+
+void GamepadGestureReset(GAMEPAD_DEVICE device) {
+	int g;
+
+	memset(&DEVICES[device], 0, sizeof(DEVICES[device]));
+	for (g = 0; g != GESTURE_GROUPS; ++g) {
+		DEVICES[device].track[g].state = ROOT[g];
+	}
+	DEVICES[device].dir = 5;
+}
+
+#else /* defined(GAMEPAD_NO_GESTURES) */
+
+int GamepadGestureAdd(const char* pattern, unsigned int window, unsigned int gap) {
+	return -1;
+}
+
+void GamepadGestureRemove(int gesture) {
+}
+
+void GamepadGestureHoldTime(unsigned int hold) {
+}
+
+void GamepadGestureFeed(GAMEPAD_DEVICE device, int symbol, unsigned int time) {
+}
+
+#endif
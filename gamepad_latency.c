@@ -0,0 +1,144 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+#include <string.h>
+
+#define GAMEPAD_EXPORT 1
+#include "gamepad_private.h"
+
+#if !defined(GAMEPAD_NO_LATENCY)
+
+/* Smallest latency bucket in microseconds; each bucket doubles it */
+#define LATENCY_FIRST_BUCKET	125
+
+/* Trace of one device */
+typedef struct LATENCY_DEVICE LATENCY_DEVICE;
+struct LATENCY_DEVICE {
+	/* device clock extended to 64 bits, and its offset to GamepadClock */
+	GAMEPAD_BOOL synced;
+	unsigned int lastTime;
+	unsigned long long millis;
+	long long offset;
+
+	/* inputs applied since the last query */
+	unsigned int pending;
+	unsigned long long oldest, newest;
+
+	/* buckets of the latest inputs, oldest first from head */
+	unsigned char window[GAMEPAD_LATENCY_WINDOW];
+	unsigned int head, filled;
+	unsigned int histogram[GAMEPAD_LATENCY_BUCKETS];
+
+	/* stamps of the input being applied */
+	unsigned long long kernel, read, applied;
+};
+
+static LATENCY_DEVICE LATENCY[GAMEPAD_COUNT];
+
+/* The device whose input is being applied, if any */
+static LATENCY_DEVICE* CURRENT = NULL;
+
+static unsigned char GamepadLatencyBucket(unsigned long long latency) {
+	unsigned char i = 0;
+	while (i != GAMEPAD_LATENCY_BUCKETS - 1 && latency >= (unsigned long long)LATENCY_FIRST_BUCKET << i) {
+		++i;
+	}
+	return i;
+}
+
+void GamepadLatencyInput(GAMEPAD_DEVICE device, unsigned int time, unsigned long long read, unsigned long long applied) {
+	LATENCY_DEVICE* l = &LATENCY[device];
+	unsigned char bucket;
+	long long offset;
+
+	/* the device clock wraps every 49 days */
+	l->millis += l->synced ? (unsigned int)(time - l->lastTime) : 0;
+	l->lastTime = time;
+
+	/*
+	 * Nothing is read before the kernel stamps it, so the smallest gap between
+	 * the two clocks is the closest estimate of their offset.
+	 */
+	offset = (long long)read - (long long)(l->millis * 1000);
+	if (!l->synced || offset < l->offset) {
+		l->offset = offset;
+		l->synced = GAMEPAD_TRUE;
+	}
+	l->kernel = (unsigned long long)((long long)(l->millis * 1000) + l->offset);
+	l->read = read;
+	l->applied = applied;
+
+	/* slide the histogram window */
+	bucket = GamepadLatencyBucket(applied - l->kernel);
+	if (l->filled == GAMEPAD_LATENCY_WINDOW) {
+		--l->histogram[l->window[l->head]];
+		l->window[l->head] = bucket;
+		l->head = (l->head + 1) % GAMEPAD_LATENCY_WINDOW;
+	} else {
+		l->window[(l->head + l->filled++) % GAMEPAD_LATENCY_WINDOW] = bucket;
+	}
+	++l->histogram[bucket];
+
+	if (l->pending++ == 0) {
+		l->oldest = l->kernel;
+	}
+	l->newest = l->kernel;
+
+	CURRENT = l;
+}
+
+void GamepadLatencyDone(GAMEPAD_DEVICE device) {
+	if (CURRENT == &LATENCY[device]) {
+		CURRENT = NULL;
+	}
+}
+
+void GamepadLatencyReset(GAMEPAD_DEVICE device) {
+	if (CURRENT == &LATENCY[device]) {
+		CURRENT = NULL;
+	}
+	memset(&LATENCY[device], 0, sizeof(LATENCY[device]));
+}
+
+void GamepadLatencyStamp(GAMEPAD_EVENT* event) {
+	/*
+	 * Events sent while an input is applied carry its stamps, including the
+	 * gestures it completes; connections and holds that complete on the clock
+	 * come from no input and get the current time.
+	 */
+	if (CURRENT != NULL && CURRENT == &LATENCY[event->device]) {
+		event->kernelStamp = CURRENT->kernel;
+		event->readStamp = CURRENT->read;
+		event->stamp = CURRENT->applied;
+	} else {
+		event->stamp = event->kernelStamp = event->readStamp = GamepadTimeMicros();
+	}
+}
+
+void GamepadGetLatency(GAMEPAD_DEVICE device, GAMEPAD_LATENCY* latency) {
+	LATENCY_DEVICE* l = &LATENCY[device];
+	unsigned long long now;
+
+	memset(latency, 0, sizeof(*latency));
+	if (l->pending != 0) {
+		now = GamepadTimeMicros();
+		latency->pending = l->pending;
+		latency->oldestAge = now > l->oldest ? (unsigned int)(now - l->oldest) : 0;
+		latency->newestAge = now > l->newest ? (unsigned int)(now - l->newest) : 0;
+		l->pending = 0;
+	}
+	latency->samples = l->filled;
+	memcpy(latency->histogram, l->histogram, sizeof(latency->histogram));
+}
+
+#else /* defined(GAMEPAD_NO_LATENCY) */
+
+void GamepadGetLatency(GAMEPAD_DEVICE device, GAMEPAD_LATENCY* latency) {
+	memset(latency, 0, sizeof(*latency));
+}
+
+#endif
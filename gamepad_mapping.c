@@ -0,0 +1,628 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GAMEPAD_EXPORT 1
+#include "gamepad_private.h"
+
+#if defined(__linux__)
+#	include <linux/input.h>
+#endif
+
+/* Platform name used to filter database entries */
+#if defined(_WIN32)
+#	define MAPPING_PLATFORM "Windows"
+#elif defined(__linux__)
+#	define MAPPING_PLATFORM "Linux"
+#endif
+
+/* Layout used for devices that have no database entry (xpad) */
+#define MAPPING_DEFAULT "00000000000000000000000000000000,Xbox 360 Controller," \
+	"a:b0,b:b1,x:b2,y:b3,leftshoulder:b4,rightshoulder:b5,back:b6,start:b7,guide:b8," \
+	"leftstick:b9,rightstick:b10,leftx:a0,lefty:a1,lefttrigger:a2,rightx:a3,righty:a4," \
+	"righttrigger:a5,dpup:h0.1,dpdown:h0.4,dpleft:h0.8,dpright:h0.2,"
+
+/* Source kinds */
+#define SOURCE_NONE		0
+#define SOURCE_BUTTON	1
+#define SOURCE_AXIS		2
+#define SOURCE_HAT		3
+
+/* Source flags */
+#define SOURCE_POS		(1<<0)	/* positive half of the axis only */
+#define SOURCE_NEG		(1<<1)	/* negative half of the axis only */
+#define SOURCE_INVERT	(1<<2)	/* axis is inverted */
+#define SOURCE_OUT_NEG	(1<<3)	/* drives the negative half of the output */
+#define SOURCE_OUT_POS	(1<<4)	/* drives the positive half of the output */
+
+/* Source of a control as written in the database */
+typedef struct MAPPING_SOURCE MAPPING_SOURCE;
+struct MAPPING_SOURCE {
+	unsigned char kind;
+	unsigned char index;
+	unsigned char mask;
+	unsigned char flags;
+};
+
+/* Parsed database entry */
+typedef struct MAPPING_ENTRY MAPPING_ENTRY;
+struct MAPPING_ENTRY {
+	unsigned short guid[4];
+	MAPPING_SOURCE button[BUTTON_COUNT];
+	MAPPING_SOURCE output[OUTPUT_COUNT];		/* whole output, or its positive half */
+	MAPPING_SOURCE outputNeg[OUTPUT_COUNT];		/* negative half of the output */
+};
+
+/* Names of the controls in the database format */
+typedef struct MAPPING_NAME MAPPING_NAME;
+struct MAPPING_NAME {
+	const char* name;
+	int button;
+	int output;
+};
+
+static const MAPPING_NAME NAMES[] = {
+	{ "a",				BUTTON_A,				-1 },
+	{ "b",				BUTTON_B,				-1 },
+	{ "x",				BUTTON_X,				-1 },
+	{ "y",				BUTTON_Y,				-1 },
+	{ "back",			BUTTON_BACK,			-1 },
+	{ "guide",			BUTTON_GUIDE,			-1 },
+	{ "start",			BUTTON_START,			-1 },
+	{ "leftstick",		BUTTON_LEFT_THUMB,		-1 },
+	{ "rightstick",		BUTTON_RIGHT_THUMB,		-1 },
+	{ "leftshoulder",	BUTTON_LEFT_SHOULDER,	-1 },
+	{ "rightshoulder",	BUTTON_RIGHT_SHOULDER,	-1 },
+	{ "dpup",			BUTTON_DPAD_UP,			-1 },
+	{ "dpdown",			BUTTON_DPAD_DOWN,		-1 },
+	{ "dpleft",			BUTTON_DPAD_LEFT,		-1 },
+	{ "dpright",		BUTTON_DPAD_RIGHT,		-1 },
+	{ "leftx",			-1,	OUTPUT_LEFTX },
+	{ "lefty",			-1,	OUTPUT_LEFTY },
+	{ "rightx",			-1,	OUTPUT_RIGHTX },
+	{ "righty",			-1,	OUTPUT_RIGHTY },
+	{ "lefttrigger",	-1,	OUTPUT_TRIGGER_LEFT },
+	{ "righttrigger",	-1,	OUTPUT_TRIGGER_RIGHT },
+	{ NULL, -1, -1 }
+};
+
+/* Fallback layout, parsed on first use */
+static MAPPING_ENTRY DEFAULT_ENTRY;
+static int DEFAULT_PARSED = 0;
+
+#if !defined(GAMEPAD_NO_MAPPING_DB)
+
+/* Database storage; TABLE is an open-addressed hash of (index + 1) into ENTRIES */
+static MAPPING_ENTRY* ENTRIES = NULL;
+static int ENTRY_COUNT = 0;
+static int ENTRY_CAPACITY = 0;
+static int* TABLE = NULL;
+static unsigned int TABLE_SIZE = 0;
+
+/* Hash a bus/vendor/product/version tuple */
+static unsigned int GamepadMappingHash(const unsigned short guid[4]) {
+	unsigned int h = 2166136261u;
+	int i;
+	for (i = 0; i != 4; ++i) {
+		h = (h ^ (guid[i] & 0xff)) * 16777619u;
+		h = (h ^ (guid[i] >> 8)) * 16777619u;
+	}
+	return h;
+}
+
+/* Find the table slot holding a GUID, or the empty slot where it belongs */
+static unsigned int GamepadMappingSlot(const unsigned short guid[4]) {
+	unsigned int mask = TABLE_SIZE - 1;
+	unsigned int i = GamepadMappingHash(guid) & mask;
+	while (TABLE[i] != 0 && memcmp(ENTRIES[TABLE[i] - 1].guid, guid, sizeof(ENTRIES[0].guid)) != 0) {
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+/* Grow the hash table once it is half full */
+static int GamepadMappingGrow(void) {
+	unsigned int size = TABLE_SIZE != 0 ? TABLE_SIZE * 2 : 256;
+	int* table = (int*)calloc(size, sizeof(int));
+	int i;
+
+	if (table == NULL) {
+		return -1;
+	}
+
+	free(TABLE);
+	TABLE = table;
+	TABLE_SIZE = size;
+
+	for (i = 0; i != ENTRY_COUNT; ++i) {
+		TABLE[GamepadMappingSlot(ENTRIES[i].guid)] = i + 1;
+	}
+	return 0;
+}
+
+/* Look up a device, ignoring the version if there is no exact match */
+static const MAPPING_ENTRY* GamepadMappingFind(const unsigned short guid[4]) {
+	unsigned short key[4];
+	unsigned int slot;
+
+	if (TABLE_SIZE == 0) {
+		return NULL;
+	}
+
+	slot = GamepadMappingSlot(guid);
+	if (TABLE[slot] != 0) {
+		return &ENTRIES[TABLE[slot] - 1];
+	}
+
+	memcpy(key, guid, sizeof(key));
+	key[3] = 0;
+	slot = GamepadMappingSlot(key);
+	if (TABLE[slot] != 0) {
+		return &ENTRIES[TABLE[slot] - 1];
+	}
+
+	return NULL;
+}
+
+#else /* defined(GAMEPAD_NO_MAPPING_DB) */
+
+/* Without a database every device gets the fallback layout */
+#define GamepadMappingFind(guid) ((const MAPPING_ENTRY*)NULL)
+
+#endif
+
+/* Parse a single hex digit */
+static int GamepadMappingHex(char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+/* Parse a source such as "b3", "-a2", "a5~" or "h0.4" */
+static int GamepadMappingParseSource(const char* text, int len, MAPPING_SOURCE* src) {
+	int value = 0;
+	int i = 0;
+
+	memset(src, 0, sizeof(*src));
+
+	if (i < len && text[i] == '+') {
+		src->flags |= SOURCE_POS;
+		++i;
+	} else if (i < len && text[i] == '-') {
+		src->flags |= SOURCE_NEG;
+		++i;
+	}
+
+	if (i == len) {
+		return -1;
+	}
+
+	switch (text[i++]) {
+	case 'b': src->kind = SOURCE_BUTTON; break;
+	case 'a': src->kind = SOURCE_AXIS; break;
+	case 'h': src->kind = SOURCE_HAT; break;
+	default: return -1;
+	}
+
+	if (i == len || text[i] < '0' || text[i] > '9') {
+		return -1;
+	}
+	while (i < len && text[i] >= '0' && text[i] <= '9') {
+		value = value * 10 + (text[i++] - '0');
+	}
+	if (value > 255) {
+		return -1;
+	}
+	src->index = (unsigned char)value;
+
+	if (src->kind == SOURCE_HAT) {
+		if (i == len || text[i++] != '.') {
+			return -1;
+		}
+		value = 0;
+		while (i < len && text[i] >= '0' && text[i] <= '9') {
+			value = value * 10 + (text[i++] - '0');
+		}
+		src->mask = (unsigned char)value;
+	}
+
+	if (i < len && text[i] == '~') {
+		src->flags |= SOURCE_INVERT;
+		++i;
+	}
+
+	return i == len ? 0 : -1;
+}
+
+/* Parse a mapping line; returns 1 if it is meant for another platform */
+static int GamepadMappingParse(const char* text, MAPPING_ENTRY* entry) {
+	unsigned char bytes[16];
+	const char* p = text;
+	int i, hi, lo;
+
+	memset(entry, 0, sizeof(*entry));
+
+	/* GUID */
+	for (i = 0; i != 16; ++i) {
+		hi = GamepadMappingHex(p[0]);
+		lo = hi >= 0 ? GamepadMappingHex(p[1]) : -1;
+		if (lo < 0) {
+			return -1;
+		}
+		bytes[i] = (unsigned char)((hi << 4) | lo);
+		p += 2;
+	}
+	if (*p++ != ',') {
+		return -1;
+	}
+
+	/* bus, vendor, product and version are little-endian; bytes 2-3 hold a CRC in newer files */
+	entry->guid[0] = (unsigned short)(bytes[0] | (bytes[1] << 8));
+	entry->guid[1] = (unsigned short)(bytes[4] | (bytes[5] << 8));
+	entry->guid[2] = (unsigned short)(bytes[8] | (bytes[9] << 8));
+	entry->guid[3] = (unsigned short)(bytes[12] | (bytes[13] << 8));
+
+	/* skip the name */
+	while (*p != ',' && *p != '\0' && *p != '\n') {
+		++p;
+	}
+
+	/* key:value pairs */
+	while (*p == ',') {
+		const char* key = ++p;
+		const char* value;
+		int keyLen, valueLen, outHalf = 0;
+
+		while (*p != ':' && *p != ',' && *p != '\0' && *p != '\n') {
+			++p;
+		}
+		if (*p != ':') {
+			break;
+		}
+		keyLen = (int)(p - key);
+		value = ++p;
+		while (*p != ',' && *p != '\0' && *p != '\n' && *p != '\r') {
+			++p;
+		}
+		valueLen = (int)(p - value);
+
+		if (keyLen == 8 && strncmp(key, "platform", 8) == 0) {
+			if (valueLen != (int)strlen(MAPPING_PLATFORM) || strncmp(value, MAPPING_PLATFORM, valueLen) != 0) {
+				return 1;
+			}
+			continue;
+		}
+
+		/* half-output prefix */
+		if (keyLen > 0 && (key[0] == '+' || key[0] == '-')) {
+			outHalf = key[0] == '-' ? SOURCE_OUT_NEG : SOURCE_OUT_POS;
+			++key;
+			--keyLen;
+		}
+
+		for (i = 0; NAMES[i].name != NULL; ++i) {
+			if ((int)strlen(NAMES[i].name) == keyLen && strncmp(NAMES[i].name, key, keyLen) == 0) {
+				MAPPING_SOURCE src;
+				if (GamepadMappingParseSource(value, valueLen, &src) != 0) {
+					return -1;
+				}
+				src.flags |= (unsigned char)outHalf;
+				if (NAMES[i].button != -1) {
+					entry->button[NAMES[i].button] = src;
+				} else if (outHalf == SOURCE_OUT_NEG) {
+					entry->outputNeg[NAMES[i].output] = src;
+				} else {
+					entry->output[NAMES[i].output] = src;
+				}
+				break;
+			}
+		}
+		/* unknown keys (paddles, touchpad, hints) are ignored */
+	}
+
+	return 0;
+}
+
+#if !defined(GAMEPAD_NO_MAPPING_DB)
+
+/* Add or replace a database entry without recompiling the devices */
+static int GamepadMappingInsert(const char* mapping) {
+	MAPPING_ENTRY entry;
+	unsigned int slot;
+	int result;
+
+	result = GamepadMappingParse(mapping, &entry);
+	if (result < 0) {
+		return -1;
+	} else if (result > 0) {
+		return 0;
+	}
+
+	/* keep the table at most half full */
+	if ((unsigned int)(ENTRY_COUNT + 1) * 2 > TABLE_SIZE && GamepadMappingGrow() != 0) {
+		return -1;
+	}
+
+	slot = GamepadMappingSlot(entry.guid);
+	if (TABLE[slot] != 0) {
+		ENTRIES[TABLE[slot] - 1] = entry;
+		result = 0;
+	} else {
+		if (ENTRY_COUNT == ENTRY_CAPACITY) {
+			int capacity = ENTRY_CAPACITY != 0 ? ENTRY_CAPACITY * 2 : 64;
+			MAPPING_ENTRY* entries = (MAPPING_ENTRY*)realloc(ENTRIES, capacity * sizeof(MAPPING_ENTRY));
+			if (entries == NULL) {
+				return -1;
+			}
+			ENTRIES = entries;
+			ENTRY_CAPACITY = capacity;
+		}
+		ENTRIES[ENTRY_COUNT] = entry;
+		TABLE[slot] = ++ENTRY_COUNT;
+		result = 1;
+	}
+
+	return result;
+}
+
+int GamepadAddMapping(const char* mapping) {
+	int result = GamepadMappingInsert(mapping);
+
+#if defined(__linux__)
+	if (result >= 0) {
+		GamepadRefreshMappings();
+	}
+#endif
+
+	return result;
+}
+
+int GamepadAddMappingsFromFile(const char* path) {
+	char line[4096];
+	int count = 0;
+	FILE* file;
+
+	file = fopen(path, "r");
+	if (file == NULL) {
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), file) != NULL) {
+		if (line[0] == '#' || line[0] == '\n' || line[0] == '\r' || line[0] == '\0') {
+			continue;
+		}
+		if (GamepadMappingInsert(line) == 1) {
+			++count;
+		}
+	}
+
+	/* the devices are compiled against the whole file at once */
+	fclose(file);
+#if defined(__linux__)
+	GamepadRefreshMappings();
+#endif
+	return count;
+}
+
+void GamepadMappingShutdown(void) {
+	free(ENTRIES);
+	free(TABLE);
+	ENTRIES = NULL;
+	TABLE = NULL;
+	ENTRY_COUNT = ENTRY_CAPACITY = 0;
+	TABLE_SIZE = 0;
+}
+
+#else /* defined(GAMEPAD_NO_MAPPING_DB) */
+
+int GamepadAddMapping(const char* mapping) {
+	return -1;
+}
+
+int GamepadAddMappingsFromFile(const char* path) {
+	return -1;
+}
+
+void GamepadMappingShutdown(void) {
+}
+
+#endif
+
+#if defined(__linux__)
+
+/* Store a binding for a database source */
+static void GamepadMappingBind(GAMEPAD_MAPPING* map, const MAPPING_SOURCE* src, GAMEPAD_BINDING bind,
+		const signed char* axisJs, int axisCount, signed char hatJs[4][2]) {
+	int js, neg;
+
+	if (src->flags & SOURCE_OUT_NEG) {
+		bind.flags |= BIND_INVERT;
+	}
+
+	switch (src->kind) {
+	case SOURCE_BUTTON:
+		if (src->index < MAPPING_MAX_BUTTONS) {
+			map->button[src->index] = bind;
+		}
+		break;
+	case SOURCE_AXIS:
+		if (src->index >= axisCount) {
+			break;
+		}
+		js = axisJs[src->index];
+
+		if ((src->flags & (SOURCE_POS|SOURCE_NEG)) != 0) {
+			/* an inverted half axis is just the other half */
+			neg = (src->flags & SOURCE_NEG) != 0;
+			if (src->flags & SOURCE_INVERT) {
+				neg = !neg;
+			}
+			/* a half output takes the half as it is */
+			if (bind.kind == BIND_AXIS && (src->flags & (SOURCE_OUT_NEG|SOURCE_OUT_POS)) == 0) {
+				bind.flags |= BIND_HALF;
+			}
+			if (neg) {
+				map->axisNeg[js] = bind;
+			} else {
+				map->axisPos[js] = bind;
+			}
+		} else if (bind.kind == BIND_BUTTON) {
+			map->axisPos[js] = bind;
+		} else {
+			bind.flags |= BIND_FULL;
+			if (src->flags & SOURCE_INVERT) {
+				bind.flags ^= BIND_INVERT;
+			}
+			map->axisNeg[js] = map->axisPos[js] = bind;
+		}
+		break;
+	case SOURCE_HAT:
+		if (src->index >= 4) {
+			break;
+		}
+		/* SDL hat masks: 1 up, 2 right, 4 down, 8 left */
+		switch (src->mask) {
+		case 1: js = hatJs[src->index][1]; neg = 1; break;
+		case 2: js = hatJs[src->index][0]; neg = 0; break;
+		case 4: js = hatJs[src->index][1]; neg = 0; break;
+		case 8: js = hatJs[src->index][0]; neg = 1; break;
+		default: js = -1; neg = 0; break;
+		}
+		if (js < 0) {
+			break;
+		}
+		if (neg) {
+			map->axisNeg[js] = bind;
+		} else {
+			map->axisPos[js] = bind;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void GamepadMappingCompile(GAMEPAD_MAPPING* map, const unsigned short guid[4], const unsigned char* axmap, int axes) {
+	const MAPPING_ENTRY* entry;
+	signed char axisJs[MAPPING_MAX_AXES];
+	signed char hatJs[4][2];
+	GAMEPAD_BINDING bind;
+	int axisCount = 0;
+	int i;
+
+	memset(map, 0, sizeof(*map));
+	memset(hatJs, -1, sizeof(hatJs));
+
+	entry = GamepadMappingFind(guid);
+	if (entry == NULL) {
+		if (!DEFAULT_PARSED) {
+			GamepadMappingParse(MAPPING_DEFAULT, &DEFAULT_ENTRY);
+			DEFAULT_PARSED = 1;
+		}
+		entry = &DEFAULT_ENTRY;
+	}
+
+	/* the joystick API numbers hats as axes, the database numbers them separately */
+	if (axes > MAPPING_MAX_AXES) {
+		axes = MAPPING_MAX_AXES;
+	}
+	for (i = 0; i != axes; ++i) {
+		if (axmap[i] >= ABS_HAT0X && axmap[i] <= ABS_HAT3Y) {
+			hatJs[(axmap[i] - ABS_HAT0X) / 2][(axmap[i] - ABS_HAT0X) & 1] = (signed char)i;
+		} else {
+			axisJs[axisCount++] = (signed char)i;
+		}
+	}
+
+	for (i = 0; i != BUTTON_COUNT; ++i) {
+		bind.kind = BIND_BUTTON;
+		bind.target = (unsigned char)i;
+		bind.flags = 0;
+		GamepadMappingBind(map, &entry->button[i], bind, axisJs, axisCount, hatJs);
+	}
+	for (i = 0; i != OUTPUT_COUNT; ++i) {
+		bind.kind = BIND_AXIS;
+		bind.target = (unsigned char)i;
+		bind.flags = 0;
+		GamepadMappingBind(map, &entry->output[i], bind, axisJs, axisCount, hatJs);
+		GamepadMappingBind(map, &entry->outputNeg[i], bind, axisJs, axisCount, hatJs);
+	}
+}
+
+/* Apply a value (-32767 to 32767) to the target of a binding */
+static void GamepadMappingApply(GAMEPAD_STATE* state, const GAMEPAD_BINDING* bind, int value) {
+	int v;
+
+	switch (bind->kind) {
+	case BIND_BUTTON:
+		if (value > 16384) {
+			state->bCurrent |= BUTTON_TO_FLAG(bind->target);
+		} else {
+			state->bCurrent &= ~BUTTON_TO_FLAG(bind->target);
+		}
+		break;
+	case BIND_AXIS:
+		v = (bind->flags & BIND_INVERT) ? -value : value;
+
+		if (bind->target >= OUTPUT_TRIGGER_LEFT) {
+			v = (bind->flags & BIND_FULL) ? (v + 32768) >> 8 : (v * 255) / 32767;
+			if (v < 0) v = 0;
+			if (v > 255) v = 255;
+			state->trigger[bind->target - OUTPUT_TRIGGER_LEFT].value = v;
+			break;
+		}
+
+		if (bind->flags & BIND_HALF) {
+			v = v * 2 - 32767;
+			if (v < -32767) v = -32767;
+		}
+
+		/* Y axes point up */
+		switch (bind->target) {
+		case OUTPUT_LEFTX:	state->stick[STICK_LEFT].x = v; break;
+		case OUTPUT_LEFTY:	state->stick[STICK_LEFT].y = -v; break;
+		case OUTPUT_RIGHTX:	state->stick[STICK_RIGHT].x = v; break;
+		case OUTPUT_RIGHTY:	state->stick[STICK_RIGHT].y = -v; break;
+		default: break;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void GamepadMappingButton(GAMEPAD_STATE* state, const GAMEPAD_MAPPING* map, int number, int value) {
+	if (number < MAPPING_MAX_BUTTONS) {
+		GamepadMappingApply(state, &map->button[number], value ? 32767 : 0);
+	}
+}
+
+void GamepadMappingAxis(GAMEPAD_STATE* state, const GAMEPAD_MAPPING* map, int number, int value) {
+	const GAMEPAD_BINDING* neg;
+
+	if (number >= MAPPING_MAX_AXES) {
+		return;
+	}
+
+	/* the idle half goes first, so the active one wins when both drive the same output */
+	neg = &map->axisNeg[number];
+	if (neg->flags & BIND_FULL) {
+		GamepadMappingApply(state, neg, value);
+	} else if (value < 0) {
+		GamepadMappingApply(state, &map->axisPos[number], 0);
+		GamepadMappingApply(state, neg, -value);
+	} else {
+		GamepadMappingApply(state, neg, 0);
+		GamepadMappingApply(state, &map->axisPos[number], value);
+	}
+}
+
+#endif
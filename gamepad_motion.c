@@ -0,0 +1,282 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+#include <string.h>
+
+#define GAMEPAD_EXPORT 1
+#include "gamepad_private.h"
+
+#if !defined(GAMEPAD_NO_MOTION) && defined(__linux__)
+
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+/* Samples kept per device; about a second at the fastest rates sensors report */
+#define MOTION_CAPACITY	1024
+
+/* Events read per system call */
+#define MOTION_BATCH	64
+
+/* Resolutions assumed when the node doesn't report them (hid-playstation) */
+#define MOTION_ACCEL_RES	8192	/* units per g */
+#define MOTION_GYRO_RES		1024	/* units per degree per second */
+
+#define MOTION_G			9.80665f
+#define MOTION_DEG_TO_RAD	0.01745329251994f
+
+/* Sensor of one device and its samples */
+typedef struct MOTION_DEVICE MOTION_DEVICE;
+struct MOTION_DEVICE {
+	int fd;
+	float accelScale, gyroScale;
+	int raw[6];						/* ABS_X..ABS_Z, ABS_RX..ABS_RZ */
+	GAMEPAD_BOOL dropped;			/* in a SYN_DROPPED gap */
+	unsigned int stamp;				/* last MSC_TIMESTAMP */
+	unsigned long long sensorTime;	/* MSC_TIMESTAMP extended to 64 bits */
+	unsigned long long lastTime;	/* sensor or arrival time of the previous sample */
+	GAMEPAD_BOOL hasStamp, started;
+	GAMEPAD_MOTION ring[MOTION_CAPACITY];
+	unsigned int head, count, overflow;
+	float bias[3];
+	double biasSum[3];
+	unsigned int biasWanted, biasCount;
+};
+
+static MOTION_DEVICE MOTION[GAMEPAD_COUNT] = {
+	{ -1 }, { -1 }, { -1 }, { -1 }
+};
+
+/* Resolution of an axis, or a default if the node doesn't say */
+static float GamepadMotionResolution(int fd, int code, int fallback) {
+	struct input_absinfo abs;
+	if (ioctl(fd, EVIOCGABS(code), &abs) != -1 && abs.resolution > 0) {
+		return (float)abs.resolution;
+	}
+	return (float)fallback;
+}
+
+GAMEPAD_BOOL GamepadMotionAttach(GAMEPAD_DEVICE device, int fd) {
+	MOTION_DEVICE* m = &MOTION[device];
+	int clockId = CLOCK_MONOTONIC;
+
+	if (fd < 0) {
+		return GAMEPAD_FALSE;
+	}
+
+	GamepadMotionDetach(device);
+	memset(m, 0, sizeof(*m));
+	m->fd = fd;
+	m->accelScale = MOTION_G / GamepadMotionResolution(fd, ABS_X, MOTION_ACCEL_RES);
+	m->gyroScale = MOTION_DEG_TO_RAD / GamepadMotionResolution(fd, ABS_RX, MOTION_GYRO_RES);
+
+	/* event times on the same clock as GamepadClock; synthetic fds just ignore this */
+	ioctl(fd, EVIOCSCLOCKID, &clockId);
+
+	GamepadWatchFd(fd);
+	return GAMEPAD_TRUE;
+}
+
+void GamepadMotionDetach(GAMEPAD_DEVICE device) {
+	if (MOTION[device].fd != -1) {
+		close(MOTION[device].fd);
+		MOTION[device].fd = -1;
+	}
+}
+
+GAMEPAD_BOOL GamepadHasMotion(GAMEPAD_DEVICE device) {
+	return MOTION[device].fd != -1 ? GAMEPAD_TRUE : GAMEPAD_FALSE;
+}
+
+/* Turn the current raw values into a sample at the end of a report */
+static void GamepadMotionPush(MOTION_DEVICE* m, const struct input_event* syn) {
+	unsigned long long arrival = (unsigned long long)syn->input_event_sec * 1000000 + syn->input_event_usec;
+	unsigned long long time = m->hasStamp ? m->sensorTime : arrival;
+	GAMEPAD_MOTION* s;
+	int i;
+
+	/* a full ring drops the oldest sample */
+	if (m->count == MOTION_CAPACITY) {
+		m->head = (m->head + 1) % MOTION_CAPACITY;
+		--m->count;
+		++m->overflow;
+	}
+	s = &m->ring[(m->head + m->count++) % MOTION_CAPACITY];
+
+	for (i = 0; i != 3; ++i) {
+		s->accel[i] = (float)m->raw[i] * m->accelScale;
+		s->gyro[i] = (float)m->raw[3 + i] * m->gyroScale;
+	}
+	s->dt = m->started ? (float)(time - m->lastTime) / 1000000.0f : 0.0f;
+	s->time = arrival;
+	m->lastTime = time;
+	m->started = GAMEPAD_TRUE;
+
+	/* gather the resting gyro bias, then apply it to everything after */
+	if (m->biasWanted != 0) {
+		for (i = 0; i != 3; ++i) {
+			m->biasSum[i] += s->gyro[i];
+		}
+		if (++m->biasCount == m->biasWanted) {
+			for (i = 0; i != 3; ++i) {
+				m->bias[i] = (float)(m->biasSum[i] / m->biasCount);
+			}
+			m->biasWanted = 0;
+		}
+	}
+	for (i = 0; i != 3; ++i) {
+		s->gyro[i] -= m->bias[i];
+	}
+}
+
+/* Reload every axis from the node after a gap; synthetic fds keep what they had */
+static void GamepadMotionResync(MOTION_DEVICE* m) {
+	struct input_absinfo abs;
+	int i;
+
+	for (i = 0; i != 3; ++i) {
+		if (ioctl(m->fd, EVIOCGABS(ABS_X + i), &abs) != -1) {
+			m->raw[i] = abs.value;
+		}
+		if (ioctl(m->fd, EVIOCGABS(ABS_RX + i), &abs) != -1) {
+			m->raw[3 + i] = abs.value;
+		}
+	}
+}
+
+static void GamepadMotionDecode(MOTION_DEVICE* m, const struct input_event* ev) {
+	switch (ev->type) {
+	case EV_ABS:
+		/* changes inside a gap are partial; the resync at its end replaces them */
+		if (m->dropped) {
+			break;
+		}
+		if (ev->code <= ABS_Z) {
+			m->raw[ev->code - ABS_X] = ev->value;
+		} else if (ev->code >= ABS_RX && ev->code <= ABS_RZ) {
+			m->raw[3 + ev->code - ABS_RX] = ev->value;
+		}
+		break;
+	case EV_MSC:
+		if (ev->code == MSC_TIMESTAMP) {
+			/* a 32-bit microsecond counter that wraps about every 71 minutes */
+			m->sensorTime += m->hasStamp ? (unsigned int)ev->value - m->stamp : 0;
+			m->stamp = (unsigned int)ev->value;
+			m->hasStamp = GAMEPAD_TRUE;
+		}
+		break;
+	case EV_SYN:
+		if (ev->code == SYN_DROPPED) {
+			m->dropped = GAMEPAD_TRUE;
+		} else if (ev->code == SYN_REPORT) {
+			/* the report ending a gap is incomplete, so take the axes from the node instead */
+			if (!m->dropped) {
+				GamepadMotionPush(m, ev);
+			} else {
+				GamepadMotionResync(m);
+			}
+			m->dropped = GAMEPAD_FALSE;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void GamepadMotionUpdate(GAMEPAD_DEVICE device) {
+	MOTION_DEVICE* m = &MOTION[device];
+	struct input_event ev[MOTION_BATCH];
+	ssize_t got;
+	int i, n;
+
+	while (m->fd != -1) {
+		got = read(m->fd, ev, sizeof(ev));
+		if (got <= 0) {
+			/* the sensor went away; a new node is paired when it comes back */
+			if (got == 0 || (errno != EAGAIN && errno != EINTR)) {
+				GamepadMotionDetach(device);
+			}
+			break;
+		}
+		n = (int)(got / sizeof(ev[0]));
+		for (i = 0; i != n; ++i) {
+			GamepadMotionDecode(m, &ev[i]);
+		}
+		if (n != MOTION_BATCH) {
+			break;
+		}
+	}
+}
+
+unsigned int GamepadMotionRead(GAMEPAD_DEVICE device, GAMEPAD_MOTION* samples, unsigned int max) {
+	MOTION_DEVICE* m = &MOTION[device];
+	unsigned int n = 0;
+
+	while (n != max && m->count != 0) {
+		samples[n++] = m->ring[m->head];
+		m->head = (m->head + 1) % MOTION_CAPACITY;
+		--m->count;
+	}
+	return n;
+}
+
+unsigned int GamepadMotionDropped(GAMEPAD_DEVICE device) {
+	return MOTION[device].overflow;
+}
+
+void GamepadMotionCalibrate(GAMEPAD_DEVICE device, unsigned int samples) {
+	MOTION_DEVICE* m = &MOTION[device];
+	memset(m->bias, 0, sizeof(m->bias));
+	memset(m->biasSum, 0, sizeof(m->biasSum));
+	m->biasCount = 0;
+	m->biasWanted = samples;
+}
+
+GAMEPAD_BOOL GamepadMotionCalibrating(GAMEPAD_DEVICE device) {
+	return MOTION[device].biasWanted != 0 ? GAMEPAD_TRUE : GAMEPAD_FALSE;
+}
+
+#else /* defined(GAMEPAD_NO_MOTION) || !defined(__linux__) */
+
+GAMEPAD_BOOL GamepadMotionAttach(GAMEPAD_DEVICE device, int fd) {
+	return GAMEPAD_FALSE;
+}
+
+void GamepadMotionDetach(GAMEPAD_DEVICE device) {
+}
+
+GAMEPAD_BOOL GamepadHasMotion(GAMEPAD_DEVICE device) {
+	return GAMEPAD_FALSE;
+}
+
+unsigned int GamepadMotionRead(GAMEPAD_DEVICE device, GAMEPAD_MOTION* samples, unsigned int max) {
+	return 0;
+}
+
+unsigned int GamepadMotionDropped(GAMEPAD_DEVICE device) {
+	return 0;
+}
+
+void GamepadMotionCalibrate(GAMEPAD_DEVICE device, unsigned int samples) {
+}
+
+GAMEPAD_BOOL GamepadMotionCalibrating(GAMEPAD_DEVICE device) {
+	return GAMEPAD_FALSE;
+}
+
+#endif
+
+void GamepadMotionIntegrate(const GAMEPAD_MOTION* samples, unsigned int count, float angles[3]) {
+	unsigned int i;
+	for (i = 0; i != count; ++i) {
+		angles[0] += samples[i].gyro[0] * samples[i].dt;
+		angles[1] += samples[i].gyro[1] * samples[i].dt;
+		angles[2] += samples[i].gyro[2] * samples[i].dt;
+	}
+}
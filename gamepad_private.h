@@ -0,0 +1,328 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+/*
+ * Internal declarations shared between the library's translation units.
+ * Nothing in here is part of the public API.
+ */
+
+#if !defined(GAMEPAD_PRIVATE_H)
+#define GAMEPAD_PRIVATE_H 1
+
+#include "gamepad.h"
+
+/*
+ * Build-time feature switches.  Defining GAMEPAD_NO_EVENTS, GAMEPAD_NO_CHANNELS,
+ * GAMEPAD_NO_MAPPING_DB, GAMEPAD_NO_WAVEFORM, GAMEPAD_NO_GESTURES,
+ * GAMEPAD_NO_MOTION, GAMEPAD_NO_URING or GAMEPAD_NO_LATENCY compiles that
+ * subsystem out; its public functions remain so the header stays valid, but
+ * they report failure.
+ */
+#if defined(GAMEPAD_NO_EVENTS) && !defined(GAMEPAD_NO_CHANNELS)
+#	define GAMEPAD_NO_CHANNELS 1	/* channels are fed by subscriptions */
+#endif
+#if defined(GAMEPAD_NO_EVENTS) && !defined(GAMEPAD_NO_GESTURES)
+#	define GAMEPAD_NO_GESTURES 1	/* gestures are delivered as events */
+#endif
+
+#if defined(__linux__)
+#	include <sys/types.h>
+#	include <linux/joystick.h>
+#endif
+
+#define BUTTON_TO_FLAG(b) (1 << (b))
+
+/* Size per-device state and shared indices are aligned to, so threads don't false-share */
+#define CACHE_LINE	64
+
+#if defined(_MSC_VER)
+#	define GAMEPAD_ALIGNED(n)	__declspec(align(n))
+#else
+#	define GAMEPAD_ALIGNED(n)	__attribute__((aligned(n)))
+#endif
+
+#if !defined(GAMEPAD_FIXED_POINT)
+
+/* Axis information */
+typedef struct GAMEPAD_AXIS GAMEPAD_AXIS;
+struct GAMEPAD_AXIS {
+	int x, y;
+	float nx, ny;
+	float length;
+	float angle;
+	unsigned char dirLast, dirCurrent;
+};
+
+/* Trigger value information */
+typedef struct GAMEPAD_TRIGINFO GAMEPAD_TRIGINFO;
+struct GAMEPAD_TRIGINFO {
+	int value;
+	float length;
+	unsigned char pressedLast, pressedCurrent;
+};
+
+#define AXIS_NX(a)				((a)->nx)
+#define AXIS_NY(a)				((a)->ny)
+#define AXIS_LENGTH(a)			((a)->length)
+#define AXIS_ANGLE(a)			((a)->angle)
+#define TRIGGER_LENGTH(t)		((t)->length)
+
+#else
+
+/*
+ * Defining GAMEPAD_FIXED_POINT keeps the derived stick and trigger values in
+ * Q15 (32768 is 1.0) and runs the deadzone, normalization and direction logic
+ * on integers.  The float accessors convert when called, and the angle is
+ * only computed then.
+ */
+typedef struct GAMEPAD_AXIS GAMEPAD_AXIS;
+struct GAMEPAD_AXIS {
+	short x, y;
+	short nx, ny;				/* Q15, clamped to 32767 */
+	unsigned short length;		/* Q15, 0 to 32768 */
+	unsigned char dirLast, dirCurrent;
+};
+
+typedef struct GAMEPAD_TRIGINFO GAMEPAD_TRIGINFO;
+struct GAMEPAD_TRIGINFO {
+	unsigned char value;
+	unsigned char pressedLast, pressedCurrent;
+	unsigned short length;		/* Q15, 0 to 32768 */
+};
+
+#define Q15_TO_FLOAT(v)			((float)(v) * (1.0f / 32768.0f))
+#define AXIS_NX(a)				Q15_TO_FLOAT((a)->nx)
+#define AXIS_NY(a)				Q15_TO_FLOAT((a)->ny)
+#define AXIS_LENGTH(a)			Q15_TO_FLOAT((a)->length)
+#define AXIS_ANGLE(a)			atan2f((float)(a)->y, (float)(a)->x)	/* 0 inside the deadzone, where x and y are cleared */
+#define TRIGGER_LENGTH(t)		Q15_TO_FLOAT((t)->length)
+
+#endif
+
+/* Number of joystick buttons and axes a mapping can address */
+#define MAPPING_MAX_BUTTONS	64
+#define MAPPING_MAX_AXES	64
+
+/* Analog outputs a mapping can drive */
+enum MAPPING_OUTPUT {
+	OUTPUT_LEFTX			= 0,
+	OUTPUT_LEFTY			= 1,
+	OUTPUT_RIGHTX			= 2,
+	OUTPUT_RIGHTY			= 3,
+	OUTPUT_TRIGGER_LEFT		= 4,
+	OUTPUT_TRIGGER_RIGHT	= 5,
+
+	OUTPUT_COUNT
+};
+
+/* Binding kinds */
+#define BIND_NONE	0
+#define BIND_BUTTON	1
+#define BIND_AXIS	2
+
+/* Binding flags */
+#define BIND_FULL	(1<<0)	/* source is a full-range axis */
+#define BIND_HALF	(1<<1)	/* source is half an axis stretched over the full output */
+#define BIND_INVERT	(1<<2)	/* negate the value before storing */
+
+/* Where a single joystick input ends up */
+typedef struct GAMEPAD_BINDING GAMEPAD_BINDING;
+struct GAMEPAD_BINDING {
+	unsigned char kind;		/* BIND_NONE, BIND_BUTTON or BIND_AXIS */
+	unsigned char target;	/* GAMEPAD_BUTTON or MAPPING_OUTPUT */
+	unsigned char flags;	/* BIND_* flags */
+};
+
+/*
+ * Compiled per-device mapping, indexed directly by joystick event number.
+ *
+ * Axes are split in halves so that hats and half-axis bindings can drive
+ * different targets from the negative and positive ranges.
+ */
+typedef struct GAMEPAD_MAPPING GAMEPAD_MAPPING;
+struct GAMEPAD_MAPPING {
+	GAMEPAD_BINDING button[MAPPING_MAX_BUTTONS];
+	GAMEPAD_BINDING axisNeg[MAPPING_MAX_AXES];
+	GAMEPAD_BINDING axisPos[MAPPING_MAX_AXES];
+};
+
+/* Longest stable device identity (vendor:product:uniq or phys) we keep */
+#define GAMEPAD_IDENTITY_SIZE	96
+
+/*
+ * Per-frame state of a gamepad: what decoding writes, GamepadUpdate derives
+ * and the accessors read.  Each device gets its own cache lines; the sticks
+ * and buttons share the first, and in fixed point everything fits in one.
+ */
+typedef struct GAMEPAD_STATE GAMEPAD_STATE;
+struct GAMEPAD_ALIGNED(CACHE_LINE) GAMEPAD_STATE {
+	GAMEPAD_AXIS stick[STICK_COUNT];
+	int bLast, bCurrent;
+	GAMEPAD_TRIGINFO trigger[TRIGGER_COUNT];
+	int flags;
+	unsigned int time;
+};
+
+#if defined(__linux__)
+/* The device nodes behind a gamepad, and what we learned probing them */
+typedef struct GAMEPAD_NODE GAMEPAD_NODE;
+struct GAMEPAD_NODE {
+	dev_t devnum;
+	int fd;
+	/* force feedback goes through the event node next to the joystick node */
+	int ffd;
+	int effect;
+	GAMEPAD_BOOL rumbling;
+	/* kept after a disconnect so the same device can be restored without probing */
+	char identity[GAMEPAD_IDENTITY_SIZE];
+	unsigned long long removed;
+	unsigned long long attachTime;
+	GAMEPAD_BOOL restored;
+	unsigned short guid[4];
+	unsigned char axes;
+	unsigned char axmap[MAPPING_MAX_AXES];
+	struct js_corr corr[MAPPING_MAX_AXES];
+	GAMEPAD_BOOL hasCorr;
+	GAMEPAD_MAPPING map;
+};
+#endif
+
+/* Note whether a gamepad is currently connected */
+#define FLAG_CONNECTED	(1<<0)
+#define FLAG_RUMBLE		(1<<1)
+
+/* Atomic helpers for state shared with other threads; MSVC needs <windows.h> */
+#if defined(_MSC_VER)
+#	define ATOMIC_LOAD(p)			(*(p))
+#	define ATOMIC_STORE(p, v)		(*(p) = (v))
+#	define ATOMIC_CAS(p, o, n)		((unsigned int)InterlockedCompareExchange((volatile LONG*)(p), (LONG)(n), (LONG)(o)) == (o))
+#	define ATOMIC_INC(p)			InterlockedIncrement((volatile LONG*)(p))
+#else
+#	define ATOMIC_LOAD(p)			__atomic_load_n((p), __ATOMIC_ACQUIRE)
+#	define ATOMIC_STORE(p, v)		__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#	define ATOMIC_CAS(p, o, n)		__sync_bool_compare_and_swap((p), (o), (n))
+#	define ATOMIC_INC(p)			__atomic_add_fetch((p), 1, __ATOMIC_RELAXED)
+#endif
+
+/* Monotonic clock in microseconds (gamepad.c) */
+unsigned long long GamepadTimeMicros(void);
+
+/* Event subscriptions (gamepad_event.c) */
+#if !defined(GAMEPAD_NO_EVENTS)
+extern unsigned int GAMEPAD_EVENT_INPUTS[GAMEPAD_COUNT][EVENT_COUNT];
+#define GamepadWantsEvent(device, type) (GAMEPAD_EVENT_INPUTS[device][type] != 0)
+void GamepadEmit			(const GAMEPAD_EVENT* event);
+void GamepadEmitEvent		(GAMEPAD_DEVICE device, GAMEPAD_EVENT_TYPE type, int input, int value, unsigned int time);
+void GamepadEmitButtons		(GAMEPAD_DEVICE device, int before, int after, unsigned int time);
+void GamepadEmitAxis		(GAMEPAD_DEVICE device, GAMEPAD_STICK stick, int x, int y, unsigned int time);
+#else
+#	define GamepadWantsEvent(device, type)						0
+#	define GamepadEmit(event)									((void)0)
+#	define GamepadEmitEvent(device, type, input, value, time)	((void)0)
+#	define GamepadEmitButtons(device, before, after, time)		((void)0)
+#	define GamepadEmitAxis(device, stick, x, y, time)			((void)0)
+#endif
+
+/* Gesture recognizer (gamepad_gesture.c) */
+#if !defined(GAMEPAD_NO_GESTURES)
+#define GESTURE_ACTIVE_DIRS		(1<<0)	/* some gesture uses directions */
+#define GESTURE_ACTIVE_BUTTONS	(1<<1)	/* some gesture uses presses, releases or holds */
+#define GESTURE_ACTIVE_HOLDS	(1<<2)	/* some gesture uses holds */
+extern unsigned int GAMEPAD_GESTURE_ACTIVE;
+#define GamepadGesturesActive()	(GAMEPAD_GESTURE_ACTIVE != 0)
+#define GamepadGestureHolds()	((GAMEPAD_GESTURE_ACTIVE & GESTURE_ACTIVE_HOLDS) != 0)
+void GamepadGestureInput	(GAMEPAD_DEVICE device, int buttons, int x, int y, unsigned int time);
+void GamepadGestureTick		(GAMEPAD_DEVICE device, unsigned long long now);
+void GamepadGestureReset	(GAMEPAD_DEVICE device);
+#else
+#	define GamepadGesturesActive()							0
+#	define GamepadGestureHolds()							0
+#	define GamepadGestureInput(device, buttons, x, y, time)	((void)0)
+#	define GamepadGestureTick(device, now)					((void)0)
+#	define GamepadGestureReset(device)						((void)0)
+#endif
+
+/* Rumble scheduler (gamepad_rumble.c) */
+void GamepadRumbleUpdate	(unsigned long long now);
+void GamepadRumbleReset		(GAMEPAD_DEVICE device);
+void GamepadRumbleShutdown	(void);
+void GamepadRumbleLock		(void);
+void GamepadRumbleUnlock	(void);
+void GamepadRumbleClaim		(GAMEPAD_DEVICE device, GAMEPAD_BOOL claimed);
+
+/* Write motor levels to the sink or the device, serialized with other writers */
+GAMEPAD_BOOL GamepadRumbleWrite(GAMEPAD_DEVICE device, unsigned short strong, unsigned short weak);
+
+/* Write motor levels to a device (gamepad.c); GAMEPAD_FALSE if it can't take them.  Called with the rumble lock held. */
+GAMEPAD_BOOL GamepadRumbleOutput(GAMEPAD_DEVICE device, unsigned short strong, unsigned short weak);
+
+/* Motion sensors (gamepad_motion.c) */
+#if !defined(GAMEPAD_NO_MOTION) && defined(__linux__)
+void GamepadMotionUpdate	(GAMEPAD_DEVICE device);
+#else
+#	define GamepadMotionUpdate(device)	((void)0)
+#endif
+
+/* Latency tracing (gamepad_latency.c) */
+#if !defined(GAMEPAD_NO_LATENCY)
+/* Note an input about to be applied; time is the device's millisecond stamp */
+void GamepadLatencyInput	(GAMEPAD_DEVICE device, unsigned int time, unsigned long long read, unsigned long long applied);
+
+/* The device's inputs of this update have been applied and their events sent */
+void GamepadLatencyDone		(GAMEPAD_DEVICE device);
+void GamepadLatencyReset	(GAMEPAD_DEVICE device);
+
+/* Fill an event's stamps from the input being applied, or with the current time */
+void GamepadLatencyStamp	(GAMEPAD_EVENT* event);
+#else
+#	define GamepadLatencyInput(device, time, read, applied)	((void)0)
+#	define GamepadLatencyDone(device)						((void)0)
+#	define GamepadLatencyReset(device)						((void)0)
+#	define GamepadLatencyStamp(event)						((event)->stamp = (event)->kernelStamp = (event)->readStamp = GamepadTimeMicros())
+#endif
+
+/* Mapping database (gamepad_mapping.c) */
+void GamepadMappingShutdown	(void);
+#if defined(__linux__)
+void GamepadMappingCompile	(GAMEPAD_MAPPING* map, const unsigned short guid[4], const unsigned char* axmap, int axes);
+void GamepadMappingButton	(GAMEPAD_STATE* state, const GAMEPAD_MAPPING* map, int number, int value);
+void GamepadMappingAxis		(GAMEPAD_STATE* state, const GAMEPAD_MAPPING* map, int number, int value);
+void GamepadRefreshMappings	(void);
+
+/* Add an fd to the set GamepadUpdate waits on (gamepad.c) */
+void GamepadWatchFd			(int fd);
+#endif
+
+/* io_uring device polls (gamepad_uring.c); without a ring every device is read each update */
+#if !defined(GAMEPAD_NO_URING) && defined(__linux__)
+extern int GAMEPAD_URING_FD;
+#define GamepadUringActive()	(GAMEPAD_URING_FD != -1)
+void GamepadUringInit			(int monitor);
+void GamepadUringShutdown		(void);
+GAMEPAD_BOOL GamepadUringAttach	(GAMEPAD_DEVICE device, int fd);
+void GamepadUringDetach			(GAMEPAD_DEVICE device);
+
+/* Collect completions; GAMEPAD_TRUE if the monitor has something to receive */
+GAMEPAD_BOOL GamepadUringReap	(void);
+
+/* GAMEPAD_TRUE once after a device's poll fires; it is then read until empty */
+GAMEPAD_BOOL GamepadUringReadable	(GAMEPAD_DEVICE device);
+
+/* Arm the polls that fired and the monitor poll */
+void GamepadUringSubmit			(void);
+#else
+#	define GamepadUringActive()				0
+#	define GamepadUringInit(monitor)		((void)0)
+#	define GamepadUringShutdown()			((void)0)
+#	define GamepadUringAttach(device, fd)	GAMEPAD_FALSE
+#	define GamepadUringDetach(device)		((void)0)
+#	define GamepadUringReap()				GAMEPAD_FALSE
+#	define GamepadUringReadable(device)		GAMEPAD_TRUE
+#	define GamepadUringSubmit()				((void)0)
+#endif
+
+#endif
@@ -0,0 +1,285 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+#include <string.h>
+
+#define GAMEPAD_EXPORT 1
+#include "gamepad_private.h"
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN 1
+#	include <windows.h>
+#else
+#	include <pthread.h>
+#endif
+
+/* Effects per device; source 0 holds the GamepadSetRumble setting */
+#define RUMBLE_SOURCES	8
+
+/* Handles pack a generation, the device and the source */
+#define RUMBLE_HANDLE(gen, device, source)	((int)(((gen) << 5) | ((device) << 3) | (source)))
+#define RUMBLE_HANDLE_GEN(h)				(((unsigned int)(h) >> 5) & 0xffff)
+#define RUMBLE_HANDLE_DEVICE(h)				(((h) >> 3) & 3)
+#define RUMBLE_HANDLE_SOURCE(h)				((h) & 7)
+
+/* A playing effect */
+typedef struct RUMBLE_SOURCE RUMBLE_SOURCE;
+struct RUMBLE_SOURCE {
+	GAMEPAD_RUMBLE effect;
+	unsigned long long start;	/* microseconds */
+	unsigned int generation;
+	GAMEPAD_BOOL active;
+};
+
+/* Sources of a device and what was last written to it */
+typedef struct RUMBLE_DEVICE RUMBLE_DEVICE;
+struct RUMBLE_DEVICE {
+	RUMBLE_SOURCE source[RUMBLE_SOURCES];
+	unsigned short strong, weak;
+	GAMEPAD_BOOL written;
+	GAMEPAD_BOOL parked;			/* absent or without motors; skipped until it reconnects */
+	volatile unsigned int claimed;	/* a waveform thread owns the motors */
+};
+
+static RUMBLE_DEVICE RUMBLE[GAMEPAD_COUNT];
+
+/* Replacement for the device writes, see GamepadSetRumbleSink */
+static GAMEPAD_RUMBLE_SINK SINK = NULL;
+static void* SINK_USER = NULL;
+
+/* Serializes writes from GamepadUpdate and waveform threads */
+#if defined(_WIN32)
+static SRWLOCK LOCK = SRWLOCK_INIT;
+#else
+static pthread_mutex_t LOCK = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+void GamepadRumbleLock(void) {
+#if defined(_WIN32)
+	AcquireSRWLockExclusive(&LOCK);
+#else
+	pthread_mutex_lock(&LOCK);
+#endif
+}
+
+void GamepadRumbleUnlock(void) {
+#if defined(_WIN32)
+	ReleaseSRWLockExclusive(&LOCK);
+#else
+	pthread_mutex_unlock(&LOCK);
+#endif
+}
+
+/* Send levels to the sink or the device; the caller holds the lock */
+static GAMEPAD_BOOL GamepadRumbleSend(GAMEPAD_DEVICE device, unsigned short strong, unsigned short weak) {
+	if (SINK != NULL) {
+		return SINK(device, strong, weak, SINK_USER);
+	}
+	return GamepadRumbleOutput(device, strong, weak);
+}
+
+GAMEPAD_BOOL GamepadRumbleWrite(GAMEPAD_DEVICE device, unsigned short strong, unsigned short weak) {
+	GAMEPAD_BOOL result;
+
+	GamepadRumbleLock();
+	result = GamepadRumbleSend(device, strong, weak);
+	GamepadRumbleUnlock();
+
+	return result;
+}
+
+void GamepadRumbleClaim(GAMEPAD_DEVICE device, GAMEPAD_BOOL claimed) {
+	ATOMIC_STORE(&RUMBLE[device].claimed, claimed ? 1u : 0u);
+}
+
+void GamepadSetRumbleSink(GAMEPAD_RUMBLE_SINK sink, void* user) {
+	int i;
+
+	GamepadRumbleLock();
+	SINK = sink;
+	SINK_USER = user;
+	GamepadRumbleUnlock();
+
+	/* the new destination hasn't seen any output yet */
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		RUMBLE[i].written = GAMEPAD_FALSE;
+		RUMBLE[i].parked = GAMEPAD_FALSE;
+	}
+}
+
+static float GamepadRumbleClamp(float v) {
+	return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+/* Envelope scale of a source at a time, or a negative value once it has ended */
+static float GamepadRumbleEnvelope(const RUMBLE_SOURCE* src, unsigned long long now) {
+	const GAMEPAD_RUMBLE* e = &src->effect;
+	float t, scale = 1.0f, fade;
+
+	if (now < src->start) {
+		return 0.0f;
+	}
+
+	t = (float)(now - src->start) / 1000.0f;
+	if (e->duration != 0 && t >= (float)e->duration) {
+		return -1.0f;
+	}
+
+	if (e->attack != 0 && t < (float)e->attack) {
+		scale = e->attackLevel + (1.0f - e->attackLevel) * t / (float)e->attack;
+	}
+	if (e->duration != 0 && e->fade != 0 && t > (float)e->duration - (float)e->fade) {
+		fade = e->fadeLevel + (1.0f - e->fadeLevel) * ((float)e->duration - t) / (float)e->fade;
+		if (fade < scale) {
+			scale = fade;
+		}
+	}
+
+	return scale;
+}
+
+int GamepadRumblePlay(GAMEPAD_DEVICE device, const GAMEPAD_RUMBLE* effect) {
+	RUMBLE_SOURCE* src;
+	int i;
+
+	for (i = 1; i != RUMBLE_SOURCES; ++i) {
+		src = &RUMBLE[device].source[i];
+		if (!src->active) {
+			src->effect = *effect;
+			src->effect.left = GamepadRumbleClamp(effect->left);
+			src->effect.right = GamepadRumbleClamp(effect->right);
+			src->effect.attackLevel = GamepadRumbleClamp(effect->attackLevel);
+			src->effect.fadeLevel = GamepadRumbleClamp(effect->fadeLevel);
+			src->start = GamepadTimeMicros() + (unsigned long long)effect->delay * 1000;
+			src->generation = (src->generation + 1) & 0xffff;
+			src->active = GAMEPAD_TRUE;
+			return RUMBLE_HANDLE(src->generation, device, i);
+		}
+	}
+
+	return -1;
+}
+
+void GamepadRumbleStop(int effect) {
+	RUMBLE_SOURCE* src;
+
+	if (effect < 0 || RUMBLE_HANDLE_SOURCE(effect) == 0) {
+		return;
+	}
+
+	src = &RUMBLE[RUMBLE_HANDLE_DEVICE(effect)].source[RUMBLE_HANDLE_SOURCE(effect)];
+	if (src->generation == RUMBLE_HANDLE_GEN(effect)) {
+		src->active = GAMEPAD_FALSE;
+	}
+}
+
+void GamepadRumbleStopAll(GAMEPAD_DEVICE device) {
+	int i;
+	for (i = 0; i != RUMBLE_SOURCES; ++i) {
+		RUMBLE[device].source[i].active = GAMEPAD_FALSE;
+	}
+}
+
+void GamepadSetRumble(GAMEPAD_DEVICE device, float left, float right) {
+	RUMBLE_SOURCE* src = &RUMBLE[device].source[0];
+
+	memset(&src->effect, 0, sizeof(src->effect));
+	src->effect.left = GamepadRumbleClamp(left);
+	src->effect.right = GamepadRumbleClamp(right);
+	src->start = 0;
+	src->active = (src->effect.left != 0.0f || src->effect.right != 0.0f) ? GAMEPAD_TRUE : GAMEPAD_FALSE;
+}
+
+void GamepadRumbleReset(GAMEPAD_DEVICE device) {
+	RUMBLE[device].written = GAMEPAD_FALSE;
+	RUMBLE[device].parked = GAMEPAD_FALSE;
+}
+
+void GamepadRumbleShutdown(void) {
+	memset(RUMBLE, 0, sizeof(RUMBLE));
+	SINK = NULL;
+	SINK_USER = NULL;
+}
+
+/* Mix every device's sources and write the ones whose output changed */
+void GamepadRumbleUpdate(unsigned long long now) {
+	RUMBLE_DEVICE* dev;
+	RUMBLE_SOURCE* src;
+	float left, right, scale;
+	unsigned short strong, weak;
+	int i, j, top;
+	GAMEPAD_BOOL mixed, claimed, result;
+
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		dev = &RUMBLE[i];
+		left = right = 0.0f;
+		top = 0;
+		mixed = GAMEPAD_FALSE;
+
+		for (j = 0; j != RUMBLE_SOURCES; ++j) {
+			src = &dev->source[j];
+			if (!src->active) {
+				continue;
+			}
+
+			scale = GamepadRumbleEnvelope(src, now);
+			if (scale < 0.0f) {
+				src->active = GAMEPAD_FALSE;
+				continue;
+			}
+			if (now < src->start) {
+				continue;
+			}
+
+			/* higher priorities mute lower ones; equal priorities add up */
+			if (!mixed) {
+				top = src->effect.priority;
+				mixed = GAMEPAD_TRUE;
+			} else if (src->effect.priority < top) {
+				continue;
+			} else if (src->effect.priority > top) {
+				top = src->effect.priority;
+				left = right = 0.0f;
+			}
+			left += src->effect.left * scale;
+			right += src->effect.right * scale;
+		}
+
+		strong = (unsigned short)(GamepadRumbleClamp(left) * 65535.0f + 0.5f);
+		weak = (unsigned short)(GamepadRumbleClamp(right) * 65535.0f + 0.5f);
+
+		/* a playing waveform overrides the mixer; rewrite once it releases the device */
+		if (ATOMIC_LOAD(&dev->claimed)) {
+			dev->written = GAMEPAD_FALSE;
+			continue;
+		}
+		if (dev->parked || (dev->written && dev->strong == strong && dev->weak == weak)) {
+			continue;
+		}
+
+		/*
+		 * A waveform may have claimed the device since the check above and
+		 * written its first sample; it claims before it takes the lock, so
+		 * looking again under the lock keeps the mixer from overwriting it.
+		 */
+		GamepadRumbleLock();
+		claimed = ATOMIC_LOAD(&dev->claimed) ? GAMEPAD_TRUE : GAMEPAD_FALSE;
+		result = claimed ? GAMEPAD_FALSE : GamepadRumbleSend((GAMEPAD_DEVICE)i, strong, weak);
+		GamepadRumbleUnlock();
+
+		if (claimed) {
+			dev->written = GAMEPAD_FALSE;
+		} else if (result) {
+			dev->strong = strong;
+			dev->weak = weak;
+			dev->written = GAMEPAD_TRUE;
+		} else if (SINK == NULL) {
+			/* a sink asks for a retry, but a pad that refused won't take the next frame either */
+			dev->parked = GAMEPAD_TRUE;
+		}
+	}
+}
@@ -0,0 +1,360 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+#define GAMEPAD_EXPORT 1
+#include "gamepad_private.h"
+
+#if !defined(GAMEPAD_NO_URING) && defined(__linux__)
+
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+/*
+ * Device polls through io_uring.  A poll stays armed on every joystick node
+ * and on the udev monitor, so an idle update only looks at the completion
+ * ring in shared memory and makes no system call.  A node whose poll fired
+ * is drained with read() until it is empty, like the read() path does every
+ * update, so input that arrives after the first event of a frame is not held
+ * back.  Reads aren't posted to the ring: joydev has no non-blocking read
+ * for io_uring to try, so a posted read would wait in a worker thread and
+ * complete at no particular time.  Polls are armed again in one system call
+ * at the end of the update; arming a poll on a node that is already readable
+ * completes it at once, so nothing that arrives in between is missed.
+ */
+
+/* Submission queue size; enough for every device, the monitor and cancels */
+#define URING_ENTRIES	16
+
+/* user_data of operations that aren't device polls; device polls carry device and generation */
+#define URING_MONITOR	0xfffffffful
+#define URING_CANCEL	0xfffffffeul
+#define URING_USER_DATA(device, generation)	(((unsigned long long)(generation) << 8) | (unsigned long long)(device))
+
+typedef struct URING_DEVICE URING_DEVICE;
+struct URING_DEVICE {
+	int fd;
+	unsigned int generation;	/* bumped on detach so late completions are dropped */
+	GAMEPAD_BOOL armed;			/* a poll is posted */
+	GAMEPAD_BOOL readable;		/* the poll fired since the device was last read */
+	GAMEPAD_BOOL failed;		/* the node hung up; wait for udev to remove it */
+};
+
+int GAMEPAD_URING_FD = -1;
+
+static URING_DEVICE URING[GAMEPAD_COUNT];
+
+static int MONITOR = -1;
+static GAMEPAD_BOOL MONITOR_POSTED = GAMEPAD_FALSE;
+
+/* Mapped rings */
+static void* SQ_MAP = NULL;
+static void* CQ_MAP = NULL;
+static size_t SQ_SIZE = 0, CQ_SIZE = 0;
+static struct io_uring_sqe* SQES = NULL;
+static size_t SQES_SIZE = 0;
+static unsigned int* SQ_TAIL;
+static unsigned int* SQ_MASK;
+static unsigned int* SQ_ARRAY;
+static unsigned int* CQ_HEAD;
+static unsigned int* CQ_TAIL;
+static unsigned int* CQ_MASK;
+static struct io_uring_cqe* CQES;
+
+/* Entries queued since the last io_uring_enter */
+static unsigned int PENDING = 0;
+
+/* Give up on the ring and hand its devices back to the read() path */
+static void GamepadUringAbandon(void) {
+	int i;
+
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		if (URING[i].fd != -1) {
+			GamepadWatchFd(URING[i].fd);
+		}
+	}
+	PENDING = 0;
+	GamepadUringShutdown();
+}
+
+/* Hand the queued operations to the kernel */
+static void GamepadUringFlush(void) {
+	int submitted;
+
+	if (PENDING == 0) {
+		return;
+	}
+
+	ATOMIC_STORE(SQ_TAIL, *SQ_TAIL + PENDING);
+	while (PENDING != 0) {
+		submitted = (int)syscall(__NR_io_uring_enter, GAMEPAD_URING_FD, PENDING, 0, 0, NULL, 0);
+		if (submitted > 0) {
+			PENDING -= (unsigned int)submitted;
+		} else if (submitted == 0 || errno != EINTR) {
+			/* polls that never get armed would leave the devices silent */
+			GamepadUringAbandon();
+			return;
+		}
+	}
+}
+
+/* Queue an operation, flushing the queue first if it is full; NULL if the ring is gone */
+static struct io_uring_sqe* GamepadUringQueue(void) {
+	unsigned int tail;
+	struct io_uring_sqe* sqe;
+
+	if (PENDING == URING_ENTRIES) {
+		GamepadUringFlush();
+	}
+	if (GAMEPAD_URING_FD == -1) {
+		return NULL;
+	}
+
+	tail = *SQ_TAIL + PENDING++;
+	sqe = &SQES[tail & *SQ_MASK];
+	memset(sqe, 0, sizeof(*sqe));
+	SQ_ARRAY[tail & *SQ_MASK] = tail & *SQ_MASK;
+	return sqe;
+}
+
+static void GamepadUringPostPoll(int fd, unsigned long long userData) {
+	struct io_uring_sqe* sqe = GamepadUringQueue();
+	if (sqe == NULL) {
+		return;
+	}
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->poll32_events = POLLIN;
+	sqe->user_data = userData;
+}
+
+static void GamepadUringArm(int device) {
+	URING_DEVICE* dev = &URING[device];
+	GamepadUringPostPoll(dev->fd, URING_USER_DATA(device, dev->generation));
+	dev->armed = GAMEPAD_TRUE;
+}
+
+void GamepadUringInit(int monitor) {
+	struct io_uring_params params;
+	struct io_uring_probe* probe;
+	unsigned char probeData[sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op)];
+	int fd, i;
+
+	memset(URING, 0, sizeof(URING));
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		URING[i].fd = -1;
+	}
+
+	/* kernels before 5.6, seccomp filters and kernel.io_uring_disabled all end up here */
+	memset(&params, 0, sizeof(params));
+	fd = (int)syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+	if (fd < 0) {
+		return;
+	}
+
+	memset(probeData, 0, sizeof(probeData));
+	probe = (struct io_uring_probe*)probeData;
+	if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0 ||
+			probe->last_op < IORING_OP_ASYNC_CANCEL ||
+			(probe->ops[IORING_OP_POLL_ADD].flags & IO_URING_OP_SUPPORTED) == 0 ||
+			(probe->ops[IORING_OP_ASYNC_CANCEL].flags & IO_URING_OP_SUPPORTED) == 0) {
+		close(fd);
+		return;
+	}
+
+	SQ_SIZE = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	CQ_SIZE = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0 && CQ_SIZE > SQ_SIZE) {
+		SQ_SIZE = CQ_SIZE;
+	}
+	SQES_SIZE = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	SQ_MAP = mmap(NULL, SQ_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+		CQ_MAP = SQ_MAP;
+		CQ_SIZE = 0;
+	} else {
+		CQ_MAP = mmap(NULL, CQ_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+	}
+	SQES = (struct io_uring_sqe*)mmap(NULL, SQES_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (SQ_MAP == MAP_FAILED || CQ_MAP == MAP_FAILED || SQES == MAP_FAILED) {
+		GAMEPAD_URING_FD = fd;
+		GamepadUringShutdown();
+		return;
+	}
+
+	SQ_TAIL = (unsigned int*)((char*)SQ_MAP + params.sq_off.tail);
+	SQ_MASK = (unsigned int*)((char*)SQ_MAP + params.sq_off.ring_mask);
+	SQ_ARRAY = (unsigned int*)((char*)SQ_MAP + params.sq_off.array);
+	CQ_HEAD = (unsigned int*)((char*)CQ_MAP + params.cq_off.head);
+	CQ_TAIL = (unsigned int*)((char*)CQ_MAP + params.cq_off.tail);
+	CQ_MASK = (unsigned int*)((char*)CQ_MAP + params.cq_off.ring_mask);
+	CQES = (struct io_uring_cqe*)((char*)CQ_MAP + params.cq_off.cqes);
+
+	GAMEPAD_URING_FD = fd;
+	PENDING = 0;
+
+	/* completions wake GamepadWait */
+	GamepadWatchFd(fd);
+
+	MONITOR = monitor;
+	MONITOR_POSTED = GAMEPAD_FALSE;
+	if (MONITOR != -1) {
+		GamepadUringPostPoll(MONITOR, URING_MONITOR);
+		MONITOR_POSTED = GAMEPAD_TRUE;
+		GamepadUringFlush();
+	}
+}
+
+void GamepadUringShutdown(void) {
+	/* closing the ring cancels whatever is still posted */
+	if (GAMEPAD_URING_FD != -1) {
+		close(GAMEPAD_URING_FD);
+		GAMEPAD_URING_FD = -1;
+	}
+	if (SQES != NULL && SQES != MAP_FAILED) {
+		munmap(SQES, SQES_SIZE);
+	}
+	if (CQ_MAP != NULL && CQ_MAP != MAP_FAILED && CQ_MAP != SQ_MAP) {
+		munmap(CQ_MAP, CQ_SIZE);
+	}
+	if (SQ_MAP != NULL && SQ_MAP != MAP_FAILED) {
+		munmap(SQ_MAP, SQ_SIZE);
+	}
+	SQ_MAP = CQ_MAP = NULL;
+	SQES = NULL;
+	MONITOR = -1;
+}
+
+GAMEPAD_BOOL GamepadUringAttach(GAMEPAD_DEVICE device, int fd) {
+	URING_DEVICE* dev = &URING[device];
+
+	if (GAMEPAD_URING_FD == -1) {
+		return GAMEPAD_FALSE;
+	}
+
+	/* input queued before the poll is armed completes it at once */
+	dev->fd = fd;
+	dev->readable = dev->failed = GAMEPAD_FALSE;
+	GamepadUringArm(device);
+	GamepadUringFlush();
+
+	/* a ring that failed the submit has already put the node in the wait set */
+	return GamepadUringActive() ? GAMEPAD_TRUE : GAMEPAD_FALSE;
+}
+
+void GamepadUringDetach(GAMEPAD_DEVICE device) {
+	URING_DEVICE* dev = &URING[device];
+	struct io_uring_sqe* sqe;
+
+	if (GAMEPAD_URING_FD == -1 || dev->fd == -1) {
+		return;
+	}
+
+	/* the ring holds its own reference to the file, so the poll must be cancelled */
+	if (dev->armed) {
+		sqe = GamepadUringQueue();
+		if (sqe != NULL) {
+			sqe->opcode = IORING_OP_ASYNC_CANCEL;
+			sqe->addr = URING_USER_DATA(device, dev->generation);
+			sqe->user_data = URING_CANCEL;
+			GamepadUringFlush();
+		}
+	}
+
+	dev->fd = -1;
+	dev->armed = dev->readable = GAMEPAD_FALSE;
+	dev->generation = (dev->generation + 1) & 0xffffff;
+}
+
+GAMEPAD_BOOL GamepadUringReap(void) {
+	GAMEPAD_BOOL monitor = GAMEPAD_FALSE;
+	unsigned int head, tail, device;
+	struct io_uring_cqe* cqe;
+	URING_DEVICE* dev;
+
+	if (GAMEPAD_URING_FD == -1) {
+		return GAMEPAD_FALSE;
+	}
+
+	head = *CQ_HEAD;
+	tail = ATOMIC_LOAD(CQ_TAIL);
+	for (; head != tail; ++head) {
+		cqe = &CQES[head & *CQ_MASK];
+
+		if (cqe->user_data == URING_MONITOR) {
+			MONITOR_POSTED = GAMEPAD_FALSE;
+			monitor = GAMEPAD_TRUE;
+			continue;
+		}
+		if (cqe->user_data == URING_CANCEL) {
+			continue;
+		}
+
+		/* completion of a device that has been detached */
+		device = (unsigned int)(cqe->user_data & 0xff);
+		if (device >= GAMEPAD_COUNT) {
+			continue;
+		}
+		dev = &URING[device];
+		if ((cqe->user_data >> 8) != dev->generation || dev->fd == -1) {
+			continue;
+		}
+
+		dev->armed = GAMEPAD_FALSE;
+		if (cqe->res < 0) {
+			/* a poll cut short is just armed again */
+			if (cqe->res != -EINTR && cqe->res != -ECANCELED) {
+				dev->failed = GAMEPAD_TRUE;
+			}
+		} else {
+			dev->readable = GAMEPAD_TRUE;
+			if ((cqe->res & (POLLERR|POLLHUP|POLLNVAL)) != 0) {
+				dev->failed = GAMEPAD_TRUE;
+			}
+		}
+	}
+	ATOMIC_STORE(CQ_HEAD, head);
+
+	return monitor;
+}
+
+GAMEPAD_BOOL GamepadUringReadable(GAMEPAD_DEVICE device) {
+	URING_DEVICE* dev = &URING[device];
+	GAMEPAD_BOOL readable = dev->readable;
+	dev->readable = GAMEPAD_FALSE;
+	return readable;
+}
+
+void GamepadUringSubmit(void) {
+	URING_DEVICE* dev;
+	int i;
+
+	if (GAMEPAD_URING_FD == -1) {
+		return;
+	}
+
+	/* arm the polls that fired */
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		dev = &URING[i];
+		if (dev->fd != -1 && !dev->failed && !dev->armed) {
+			GamepadUringArm(i);
+		}
+	}
+	if (MONITOR != -1 && !MONITOR_POSTED) {
+		GamepadUringPostPoll(MONITOR, URING_MONITOR);
+		MONITOR_POSTED = GAMEPAD_TRUE;
+	}
+
+	GamepadUringFlush();
+}
+
+#endif
@@ -0,0 +1,279 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define GAMEPAD_EXPORT 1
+#include "gamepad_private.h"
+
+#if !defined(GAMEPAD_NO_WAVEFORM)
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN 1
+#	include <windows.h>
+#else
+#	include <errno.h>
+#	include <time.h>
+#	include <pthread.h>
+#endif
+
+/* Longest the playing thread sleeps before checking for a stop */
+#define WAVEFORM_MAX_SLEEP	10000
+
+/*
+ * Double-buffered sample stream.  The caller fills buffer[fill] and publishes
+ * it by storing its sample count; the thread plays buffer[play] and hands it
+ * back by storing a count of zero.
+ */
+struct GAMEPAD_WAVEFORM {
+	GAMEPAD_DEVICE device;
+	unsigned int rate;
+	unsigned int capacity;
+	unsigned short* buffer[2];
+	volatile unsigned int count[2];
+	unsigned int fill;
+	unsigned int play;
+	unsigned long long start;
+	volatile unsigned int stop;
+	volatile unsigned int position;
+	volatile unsigned int underruns;
+	GAMEPAD_BOOL running;
+#if defined(_WIN32)
+	HANDLE thread;
+#else
+	pthread_t thread;
+#endif
+};
+
+/* Sleep until a GamepadClock time, waking up now and then to check for a stop */
+static void GamepadWaveformSleep(GAMEPAD_WAVEFORM* waveform, unsigned long long until) {
+	unsigned long long now, wake;
+#if defined(_WIN32)
+	for (;;) {
+		now = GamepadTimeMicros();
+		if (now >= until || ATOMIC_LOAD(&waveform->stop)) {
+			return;
+		}
+		wake = until - now;
+		if (wake > 2000) {
+			Sleep((DWORD)((wake > WAVEFORM_MAX_SLEEP ? WAVEFORM_MAX_SLEEP : wake) / 1000 - 1));
+		} else {
+			SwitchToThread();
+		}
+	}
+#else
+	struct timespec ts;
+	for (;;) {
+		now = GamepadTimeMicros();
+		if (now >= until || ATOMIC_LOAD(&waveform->stop)) {
+			return;
+		}
+		wake = until - now > WAVEFORM_MAX_SLEEP ? now + WAVEFORM_MAX_SLEEP : until;
+		ts.tv_sec = (time_t)(wake / 1000000);
+		ts.tv_nsec = (long)(wake % 1000000) * 1000;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+		}
+	}
+#endif
+}
+
+/* Playing thread: one sample per tick, written only when it changes */
+static void GamepadWaveformRun(GAMEPAD_WAVEFORM* waveform) {
+	unsigned short strong = 0, weak = 0, lastStrong = 0, lastWeak = 0;
+	unsigned int n, pos = 0, avail;
+	GAMEPAD_BOOL written = GAMEPAD_FALSE;
+
+	for (n = 0; ; ++n) {
+		/* absolute deadlines keep the error from adding up */
+		GamepadWaveformSleep(waveform, waveform->start + (unsigned long long)n * 1000000 / waveform->rate);
+		if (ATOMIC_LOAD(&waveform->stop)) {
+			break;
+		}
+		if (n == 0) {
+			GamepadRumbleClaim(waveform->device, GAMEPAD_TRUE);
+		}
+
+		avail = ATOMIC_LOAD(&waveform->count[waveform->play]);
+		if (avail == 0) {
+			strong = weak = 0;
+			ATOMIC_INC(&waveform->underruns);
+		} else {
+			strong = waveform->buffer[waveform->play][pos * 2];
+			weak = waveform->buffer[waveform->play][pos * 2 + 1];
+			if (++pos == avail) {
+				pos = 0;
+				ATOMIC_STORE(&waveform->count[waveform->play], 0u);
+				waveform->play ^= 1;
+			}
+		}
+
+		if (!written || strong != lastStrong || weak != lastWeak) {
+			if (GamepadRumbleWrite(waveform->device, strong, weak)) {
+				lastStrong = strong;
+				lastWeak = weak;
+				written = GAMEPAD_TRUE;
+			}
+		}
+
+		ATOMIC_STORE(&waveform->position, n + 1);
+	}
+
+	/* leave the motors off and hand them back to the effect mixer */
+	if (written && (lastStrong != 0 || lastWeak != 0)) {
+		GamepadRumbleWrite(waveform->device, 0, 0);
+	}
+	if (n != 0) {
+		GamepadRumbleClaim(waveform->device, GAMEPAD_FALSE);
+	}
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI GamepadWaveformThread(LPVOID param) {
+	GamepadWaveformRun((GAMEPAD_WAVEFORM*)param);
+	return 0;
+}
+#else
+static void* GamepadWaveformThread(void* param) {
+	GamepadWaveformRun((GAMEPAD_WAVEFORM*)param);
+	return NULL;
+}
+#endif
+
+GAMEPAD_WAVEFORM* GamepadWaveformCreate(GAMEPAD_DEVICE device, unsigned int rate, unsigned int capacity) {
+	GAMEPAD_WAVEFORM* waveform;
+
+	if (rate == 0 || capacity == 0) {
+		return NULL;
+	}
+
+	waveform = (GAMEPAD_WAVEFORM*)calloc(1, sizeof(GAMEPAD_WAVEFORM));
+	if (waveform == NULL) {
+		return NULL;
+	}
+
+	waveform->buffer[0] = (unsigned short*)malloc(capacity * 2 * sizeof(unsigned short));
+	waveform->buffer[1] = (unsigned short*)malloc(capacity * 2 * sizeof(unsigned short));
+	if (waveform->buffer[0] == NULL || waveform->buffer[1] == NULL) {
+		free(waveform->buffer[0]);
+		free(waveform->buffer[1]);
+		free(waveform);
+		return NULL;
+	}
+
+	waveform->device = device;
+	waveform->rate = rate;
+	waveform->capacity = capacity;
+	return waveform;
+}
+
+void GamepadWaveformDestroy(GAMEPAD_WAVEFORM* waveform) {
+	if (waveform != NULL) {
+		GamepadWaveformStop(waveform);
+		free(waveform->buffer[0]);
+		free(waveform->buffer[1]);
+		free(waveform);
+	}
+}
+
+unsigned int GamepadWaveformQueue(GAMEPAD_WAVEFORM* waveform, const unsigned short* samples, unsigned int count) {
+	if (count == 0 || ATOMIC_LOAD(&waveform->count[waveform->fill]) != 0) {
+		return 0;
+	}
+
+	if (count > waveform->capacity) {
+		count = waveform->capacity;
+	}
+	memcpy(waveform->buffer[waveform->fill], samples, count * 2 * sizeof(unsigned short));
+	ATOMIC_STORE(&waveform->count[waveform->fill], count);
+	waveform->fill ^= 1;
+
+	return count;
+}
+
+GAMEPAD_BOOL GamepadWaveformStart(GAMEPAD_WAVEFORM* waveform, unsigned long long start) {
+	if (waveform->running) {
+		return GAMEPAD_FALSE;
+	}
+
+	waveform->start = start != 0 ? start : GamepadTimeMicros();
+	waveform->stop = 0;
+	waveform->position = 0;
+	waveform->underruns = 0;
+
+#if defined(_WIN32)
+	waveform->thread = CreateThread(NULL, 0, GamepadWaveformThread, waveform, 0, NULL);
+	if (waveform->thread == NULL) {
+		return GAMEPAD_FALSE;
+	}
+	SetThreadPriority(waveform->thread, THREAD_PRIORITY_TIME_CRITICAL);
+#else
+	if (pthread_create(&waveform->thread, NULL, GamepadWaveformThread, waveform) != 0) {
+		return GAMEPAD_FALSE;
+	}
+#endif
+
+	waveform->running = GAMEPAD_TRUE;
+	return GAMEPAD_TRUE;
+}
+
+void GamepadWaveformStop(GAMEPAD_WAVEFORM* waveform) {
+	if (!waveform->running) {
+		return;
+	}
+
+	ATOMIC_STORE(&waveform->stop, 1u);
+#if defined(_WIN32)
+	WaitForSingleObject(waveform->thread, INFINITE);
+	CloseHandle(waveform->thread);
+#else
+	pthread_join(waveform->thread, NULL);
+#endif
+	waveform->running = GAMEPAD_FALSE;
+
+	waveform->count[0] = 0;
+	waveform->count[1] = 0;
+	waveform->fill = waveform->play = 0;
+}
+
+unsigned int GamepadWaveformPosition(GAMEPAD_WAVEFORM* waveform) {
+	return ATOMIC_LOAD(&waveform->position);
+}
+
+unsigned int GamepadWaveformUnderruns(GAMEPAD_WAVEFORM* waveform) {
+	return ATOMIC_LOAD(&waveform->underruns);
+}
+
+#else /* defined(GAMEPAD_NO_WAVEFORM) */
+
+GAMEPAD_WAVEFORM* GamepadWaveformCreate(GAMEPAD_DEVICE device, unsigned int rate, unsigned int capacity) {
+	return NULL;
+}
+
+void GamepadWaveformDestroy(GAMEPAD_WAVEFORM* waveform) {
+}
+
+unsigned int GamepadWaveformQueue(GAMEPAD_WAVEFORM* waveform, const unsigned short* samples, unsigned int count) {
+	return 0;
+}
+
+GAMEPAD_BOOL GamepadWaveformStart(GAMEPAD_WAVEFORM* waveform, unsigned long long start) {
+	return GAMEPAD_FALSE;
+}
+
+void GamepadWaveformStop(GAMEPAD_WAVEFORM* waveform) {
+}
+
+unsigned int GamepadWaveformPosition(GAMEPAD_WAVEFORM* waveform) {
+	return 0;
+}
+
+unsigned int GamepadWaveformUnderruns(GAMEPAD_WAVEFORM* waveform) {
+	return 0;
+}
+
+#endif
@@ -14,7 +14,7 @@ static const char* button_names[] = {
 	"right thumb",
 	"left shoulder",
 	"right shoulder",
-	"???",
+	"guide",
 	"???",
 	"A",
 	"B",
@@ -22,6 +22,12 @@ static const char* button_names[] = {
 	"Y"
 };
 
+/* In the order they are registered */
+static const char* gesture_names[] = {
+	"quarter circle + A",
+	"double tap A"
+};
+
 static int line = 0;
 
 static void logevent(const char* format, ...) {
@@ -42,6 +48,37 @@ static void logevent(const char* format, ...) {
 	}
 }
 
+static void onevent(const GAMEPAD_EVENT* event, void* user) {
+	switch (event->type) {
+	case EVENT_CONNECTED:
+		logevent("[%d] connected", event->device);
+		break;
+	case EVENT_DISCONNECTED:
+		logevent("[%d] disconnected", event->device);
+		break;
+	case EVENT_BUTTON_DOWN:
+		logevent("[%d] button triggered: %s", event->device, button_names[event->input]);
+		break;
+	case EVENT_BUTTON_UP:
+		logevent("[%d] button released:  %s", event->device, button_names[event->input]);
+		break;
+	case EVENT_TRIGGER_DOWN:
+		logevent("[%d] trigger pressed:  %d", event->device, event->input);
+		break;
+	case EVENT_TRIGGER_UP:
+		logevent("[%d] trigger released: %d", event->device, event->input);
+		break;
+	case EVENT_STICK_DIR:
+		logevent("[%d] stick direction:  %d -> %d", event->device, event->input, event->value);
+		break;
+	case EVENT_GESTURE:
+		logevent("[%d] gesture:          %s", event->device, gesture_names[event->input]);
+		break;
+	default:
+		break;
+	}
+}
+
 static void update(GAMEPAD_DEVICE dev) {
 	float lx, ly, rx, ry;
 
@@ -85,7 +122,7 @@ static void update(GAMEPAD_DEVICE dev) {
 }
 
 int main() {
-	int ch, i, j, k;
+	int ch, i;
 
 	initscr();
 	cbreak();
@@ -93,6 +130,9 @@ int main() {
 	timeout(1);
 
 	GamepadInit();
+	GamepadGestureAdd("2 3 6 a", 500, 0);
+	GamepadGestureAdd("a a", 300, 0);
+	GamepadSubscribe(GAMEPAD_MASK_ALL, GAMEPAD_MASK_ALL & ~GAMEPAD_MASK(EVENT_AXIS), GAMEPAD_MASK_ALL, 0, onevent, NULL);
 
 	while ((ch = getch()) != 'q') {
 		GamepadUpdate();
@@ -108,32 +148,6 @@ int main() {
 		update(GAMEPAD_2);
 		update(GAMEPAD_3);
 
-		for (i = 0; i != GAMEPAD_COUNT; ++i) {
-			if (GamepadIsConnected(i)) {
-				for (j = 0; j != BUTTON_COUNT; ++j) {
-					if (GamepadButtonTriggered(i, j)) {
-						logevent("[%d] button triggered: %s", i, button_names[j]);
-					} else if (GamepadButtonReleased(i, j)) {
-						logevent("[%d] button released:  %s", i, button_names[j]);
-					}
-				}
-				for (j = 0; j != TRIGGER_COUNT; ++j) {
-					if (GamepadTriggerTriggered(i, j)) {
-						logevent("[%d] trigger pressed:  %d", i, j);
-					} else if (GamepadTriggerReleased(i, j)) {
-						logevent("[%d] trigger released: %d", i, j);
-					}
-				}
-				for (j = 0; j != STICK_COUNT; ++j) {
-					for (k = 0; k != STICKDIR_COUNT; ++k) {
-						if (GamepadStickDirTriggered(i, j, k)) {
-							logevent("[%d] stick direction:  %d -> %d", i, j, k);
-						}
-					}
-				}
-			}
-		}
-
 		move(6, 0);
 		printw("(q)uit (r)umble");
 
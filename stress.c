@@ -0,0 +1,740 @@
+/**
+ * Gamepad Input Library
+ * Sean Middleditch
+ * Copyright (C) 2010  Sean Middleditch
+ * LICENSE: MIT/X
+ */
+
+/*
+ * Hotplug stress harness.  Run "stress [cycles]".
+ *
+ * The library is compiled in together with a scripted stand-in for libudev:
+ * devices are FIFOs in a scratch directory, and the monitor hands out add and
+ * remove events the harness queues.  Each phase churns devices while timing
+ * every GamepadUpdate, and checks that the slots match the devices plugged,
+ * that no slot reports input from another device, and that descriptors,
+ * heap and udev objects all come back at the end.
+ */
+
+#include "gamepad_all.c"
+
+#include <dirent.h>
+#include <malloc.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+/* Fake devices; more than GAMEPAD_COUNT so the slots run out */
+#define FAKE_COUNT		(GAMEPAD_COUNT + 2)
+
+/* Pending monitor events */
+#define FAKE_QUEUE		64
+
+/* Events a streaming device writes per update */
+#define FAKE_BURST		8
+
+/* Updates timed per phase, at most */
+#define STRESS_SAMPLES	100000
+
+/* A joystick node and its input device */
+typedef struct FAKE FAKE;
+struct FAKE {
+	char uniq[32];
+	char devnode[256];
+	char syspath[64];
+	dev_t devnum;
+	int writer;					/* harness end of the FIFO, or -1 */
+	GAMEPAD_BOOL plugged;
+	unsigned int sent;
+};
+
+/* Snapshot of a fake device as udev reports it; outlives the device */
+struct udev_device {
+	int refs;
+	char uniq[32];
+	char devnode[256];
+	char syspath[64];
+	const char* action;
+	dev_t devnum;
+};
+
+struct udev {
+	int refs;
+};
+
+struct udev_monitor {
+	int refs;
+	int fds[2];
+	struct udev_device* queue[FAKE_QUEUE];
+	unsigned int head, count;
+};
+
+struct udev_list_entry {
+	char name[64];
+	struct udev_list_entry* next;
+};
+
+struct udev_enumerate {
+	GAMEPAD_BOOL subsystem, filtered;
+	struct udev_list_entry entries[FAKE_COUNT];
+	struct udev_list_entry* first;
+};
+
+static FAKE FAKES[FAKE_COUNT];
+static char FAKE_DIR[64];
+static struct udev_monitor* FAKE_MONITOR = NULL;
+static unsigned int FAKE_NODES = 0;		/* joystick nodes created, for devnums */
+static int FAKE_OBJECTS = 0;			/* udev objects not yet released */
+
+static int STRESS_FAILURES = 0;
+static unsigned long long STRESS_TIMES[STRESS_SAMPLES];
+static unsigned int STRESS_COUNT = 0;
+static GAMEPAD_BOOL STRESS_QUIET = GAMEPAD_FALSE;
+
+/* What the subscriber has been told */
+static GAMEPAD_BOOL SEEN_CONNECTED[GAMEPAD_COUNT];
+static unsigned int SEEN_CONNECTS = 0, SEEN_DISCONNECTS = 0;
+
+#define STRESS_CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		fprintf(stderr, "stress: "); \
+		fprintf(stderr, __VA_ARGS__); \
+		fprintf(stderr, "\n"); \
+		++STRESS_FAILURES; \
+	} \
+} while (0)
+
+/* ---- scripted libudev ---- */
+
+static struct udev_device* FakeSnapshot(const FAKE* fake, const char* action) {
+	struct udev_device* dev = (struct udev_device*)calloc(1, sizeof(struct udev_device));
+	dev->refs = 1;
+	memcpy(dev->uniq, fake->uniq, sizeof(dev->uniq));
+	memcpy(dev->devnode, fake->devnode, sizeof(dev->devnode));
+	memcpy(dev->syspath, fake->syspath, sizeof(dev->syspath));
+	dev->action = action;
+	dev->devnum = fake->devnum;
+	++FAKE_OBJECTS;
+	return dev;
+}
+
+struct udev* udev_new(void) {
+	struct udev* u = (struct udev*)calloc(1, sizeof(struct udev));
+	u->refs = 1;
+	++FAKE_OBJECTS;
+	return u;
+}
+
+struct udev* udev_unref(struct udev* u) {
+	if (u != NULL && --u->refs == 0) {
+		free(u);
+		--FAKE_OBJECTS;
+	}
+	return NULL;
+}
+
+struct udev_monitor* udev_monitor_new_from_netlink(struct udev* u, const char* name) {
+	struct udev_monitor* m = (struct udev_monitor*)calloc(1, sizeof(struct udev_monitor));
+	m->refs = 1;
+	if (pipe(m->fds) == -1) {
+		free(m);
+		return NULL;
+	}
+	fcntl(m->fds[0], F_SETFL, O_NONBLOCK);
+	fcntl(m->fds[1], F_SETFL, O_NONBLOCK);
+	++FAKE_OBJECTS;
+	FAKE_MONITOR = m;
+	return m;
+}
+
+int udev_monitor_enable_receiving(struct udev_monitor* m) {
+	return 0;
+}
+
+int udev_monitor_filter_add_match_subsystem_devtype(struct udev_monitor* m, const char* subsystem, const char* devtype) {
+	return 0;
+}
+
+int udev_monitor_get_fd(struct udev_monitor* m) {
+	return m->fds[0];
+}
+
+struct udev_device* udev_monitor_receive_device(struct udev_monitor* m) {
+	struct udev_device* dev;
+	char byte;
+
+	if (read(m->fds[0], &byte, 1) != 1 || m->count == 0) {
+		return NULL;
+	}
+	dev = m->queue[m->head];
+	m->head = (m->head + 1) % FAKE_QUEUE;
+	--m->count;
+	return dev;
+}
+
+struct udev_monitor* udev_monitor_unref(struct udev_monitor* m) {
+	if (m != NULL && --m->refs == 0) {
+		while (m->count != 0) {
+			udev_device_unref(m->queue[m->head]);
+			m->head = (m->head + 1) % FAKE_QUEUE;
+			--m->count;
+		}
+		close(m->fds[0]);
+		close(m->fds[1]);
+		if (FAKE_MONITOR == m) {
+			FAKE_MONITOR = NULL;
+		}
+		free(m);
+		--FAKE_OBJECTS;
+	}
+	return NULL;
+}
+
+struct udev_enumerate* udev_enumerate_new(struct udev* u) {
+	struct udev_enumerate* e = (struct udev_enumerate*)calloc(1, sizeof(struct udev_enumerate));
+	++FAKE_OBJECTS;
+	return e;
+}
+
+int udev_enumerate_add_match_subsystem(struct udev_enumerate* e, const char* subsystem) {
+	e->subsystem = strcmp(subsystem, "input") == 0 ? GAMEPAD_TRUE : GAMEPAD_FALSE;
+	return 0;
+}
+
+/* Fake devices have no event or sensor nodes next to them */
+int udev_enumerate_add_match_parent(struct udev_enumerate* e, struct udev_device* parent) {
+	e->filtered = GAMEPAD_TRUE;
+	return 0;
+}
+
+int udev_enumerate_add_match_property(struct udev_enumerate* e, const char* property, const char* value) {
+	e->filtered = GAMEPAD_TRUE;
+	return 0;
+}
+
+int udev_enumerate_add_match_sysname(struct udev_enumerate* e, const char* sysname) {
+	e->filtered = GAMEPAD_TRUE;
+	return 0;
+}
+
+int udev_enumerate_scan_devices(struct udev_enumerate* e) {
+	struct udev_list_entry** link = &e->first;
+	int i;
+
+	if (!e->subsystem || e->filtered) {
+		return 0;
+	}
+	for (i = 0; i != FAKE_COUNT; ++i) {
+		if (FAKES[i].plugged) {
+			memcpy(e->entries[i].name, FAKES[i].syspath, sizeof(FAKES[i].syspath));
+			*link = &e->entries[i];
+			link = &e->entries[i].next;
+		}
+	}
+	*link = NULL;
+	return 0;
+}
+
+struct udev_list_entry* udev_enumerate_get_list_entry(struct udev_enumerate* e) {
+	return e->first;
+}
+
+struct udev_enumerate* udev_enumerate_unref(struct udev_enumerate* e) {
+	if (e != NULL) {
+		free(e);
+		--FAKE_OBJECTS;
+	}
+	return NULL;
+}
+
+struct udev_list_entry* udev_list_entry_get_next(struct udev_list_entry* entry) {
+	return entry->next;
+}
+
+const char* udev_list_entry_get_name(struct udev_list_entry* entry) {
+	return entry->name;
+}
+
+struct udev_device* udev_device_new_from_syspath(struct udev* u, const char* syspath) {
+	int i;
+	for (i = 0; i != FAKE_COUNT; ++i) {
+		if (FAKES[i].plugged && strcmp(FAKES[i].syspath, syspath) == 0) {
+			return FakeSnapshot(&FAKES[i], NULL);
+		}
+	}
+	return NULL;
+}
+
+struct udev_device* udev_device_ref(struct udev_device* dev) {
+	++dev->refs;
+	return dev;
+}
+
+struct udev_device* udev_device_unref(struct udev_device* dev) {
+	if (dev != NULL && --dev->refs == 0) {
+		free(dev);
+		--FAKE_OBJECTS;
+	}
+	return NULL;
+}
+
+const char* udev_device_get_syspath(struct udev_device* dev) {
+	return dev != NULL ? dev->syspath : NULL;
+}
+
+const char* udev_device_get_sysname(struct udev_device* dev) {
+	return strrchr(dev->syspath, '/') + 1;
+}
+
+const char* udev_device_get_devnode(struct udev_device* dev) {
+	return dev != NULL ? dev->devnode : NULL;
+}
+
+const char* udev_device_get_action(struct udev_device* dev) {
+	return dev != NULL ? dev->action : NULL;
+}
+
+dev_t udev_device_get_devnum(struct udev_device* dev) {
+	return dev->devnum;
+}
+
+/* The node carries the attributes of its input device itself */
+struct udev_device* udev_device_get_parent_with_subsystem_devtype(struct udev_device* dev, const char* subsystem, const char* devtype) {
+	return dev;
+}
+
+const char* udev_device_get_sysattr_value(struct udev_device* dev, const char* attr) {
+	if (strcmp(attr, "uniq") == 0) {
+		return dev->uniq;
+	}
+	if (strcmp(attr, "id/bustype") == 0) {
+		return "0003";
+	}
+	if (strcmp(attr, "id/vendor") == 0) {
+		return "045e";
+	}
+	if (strcmp(attr, "id/product") == 0) {
+		return "028e";
+	}
+	return NULL;
+}
+
+const char* udev_device_get_property_value(struct udev_device* dev, const char* key) {
+	return NULL;
+}
+
+/* ---- fake devices ---- */
+
+static void FakeAnnounce(FAKE* fake, const char* action) {
+	struct udev_monitor* m = FAKE_MONITOR;
+	char byte = 0;
+
+	if (m == NULL) {
+		return;
+	}
+	if (m->count == FAKE_QUEUE) {
+		STRESS_CHECK(0, "monitor queue overflowed; udev would drop the event");
+		return;
+	}
+	m->queue[(m->head + m->count++) % FAKE_QUEUE] = FakeSnapshot(fake, action);
+	if (write(m->fds[1], &byte, 1) != 1) {
+		STRESS_CHECK(0, "monitor pipe full");
+	}
+}
+
+/* Create a new node for a device; announce it unless it is there before GamepadInit */
+static void FakePlug(int index, GAMEPAD_BOOL announce) {
+	FAKE* fake = &FAKES[index];
+	unsigned int node = FAKE_NODES++;
+
+	snprintf(fake->uniq, sizeof(fake->uniq), "00:11:22:33:44:%02x", index);
+	snprintf(fake->devnode, sizeof(fake->devnode), "%s/js%u", FAKE_DIR, node);
+	snprintf(fake->syspath, sizeof(fake->syspath), "/sys/devices/virtual/input/input%u/js%u", node, node);
+	fake->devnum = makedev(13, node);
+	fake->sent = 0;
+
+	/* opened read-write so the FIFO has a writer before the library opens it */
+	mkfifo(fake->devnode, 0600);
+	fake->writer = open(fake->devnode, O_RDWR|O_NONBLOCK|O_CLOEXEC);
+	STRESS_CHECK(fake->writer != -1, "cannot open %s", fake->devnode);
+	fake->plugged = GAMEPAD_TRUE;
+
+	if (announce) {
+		FakeAnnounce(fake, "add");
+	}
+}
+
+/* Remove the node; the library sees end of file on its next read */
+static void FakeUnplug(int index) {
+	FAKE* fake = &FAKES[index];
+	if (!fake->plugged) {
+		return;
+	}
+	if (fake->writer != -1) {
+		close(fake->writer);
+		fake->writer = -1;
+	}
+	unlink(fake->devnode);
+	fake->plugged = GAMEPAD_FALSE;
+	FakeAnnounce(fake, "remove");
+}
+
+/* Move the left stick; the value says which device sent it */
+static void FakeFeed(int index, int count) {
+	FAKE* fake = &FAKES[index];
+	struct js_event je[FAKE_BURST];
+	int i;
+
+	if (fake->writer == -1) {
+		return;
+	}
+	if (count > FAKE_BURST) {
+		count = FAKE_BURST;
+	}
+	for (i = 0; i != count; ++i) {
+		je[i].time = fake->sent;
+		je[i].value = (short)((index + 1) * 1000 + (int)(fake->sent++ % 500));
+		je[i].type = JS_EVENT_AXIS;
+		je[i].number = 0;
+	}
+	/* a full FIFO drops the burst, like a device nobody reads */
+	if (write(fake->writer, je, count * sizeof(je[0])) < 0) {
+		return;
+	}
+}
+
+/* Fake device a slot is attached to, or -1 */
+static int FakeOfSlot(int slot) {
+	int i;
+	if ((STATE[slot].flags & FLAG_CONNECTED) == 0) {
+		return -1;
+	}
+	for (i = 0; i != FAKE_COUNT; ++i) {
+		if (FAKES[i].devnum == NODE[slot].devnum) {
+			return i;
+		}
+	}
+	return -2;
+}
+
+/* ---- measurement ---- */
+
+static unsigned long long StressNanos(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int StressOpenFds(void) {
+	DIR* dir = opendir("/proc/self/fd");
+	struct dirent* entry;
+	int count = 0;
+
+	if (dir == NULL) {
+		return -1;
+	}
+	while ((entry = readdir(dir)) != NULL) {
+		if (entry->d_name[0] != '.') {
+			++count;
+		}
+	}
+	closedir(dir);
+	return count - 1;	/* the directory itself */
+}
+
+static size_t StressHeap(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	return mallinfo2().uordblks;
+#else
+	return (size_t)mallinfo().uordblks;
+#endif
+}
+
+static void onevent(const GAMEPAD_EVENT* event, void* user) {
+	int fake, slot = event->device;
+
+	switch (event->type) {
+	case EVENT_CONNECTED:
+		STRESS_CHECK(!SEEN_CONNECTED[slot], "slot %d connected twice", slot);
+		SEEN_CONNECTED[slot] = GAMEPAD_TRUE;
+		++SEEN_CONNECTS;
+		break;
+	case EVENT_DISCONNECTED:
+		STRESS_CHECK(SEEN_CONNECTED[slot], "slot %d disconnected while not connected", slot);
+		SEEN_CONNECTED[slot] = GAMEPAD_FALSE;
+		++SEEN_DISCONNECTS;
+		break;
+	case EVENT_AXIS:
+		fake = FakeOfSlot(slot);
+		STRESS_CHECK(SEEN_CONNECTED[slot], "slot %d moved while disconnected", slot);
+		STRESS_CHECK(event->x == 0 || event->x / 1000 - 1 == fake,
+			"slot %d of device %d got input from device %d", slot, fake, event->x / 1000 - 1);
+		break;
+	default:
+		break;
+	}
+}
+
+/* Timed update, then the slots must agree with the devices */
+static void StressUpdate(void) {
+	unsigned long long start = StressNanos();
+	int i, j, fake;
+
+	GamepadUpdate();
+	if (STRESS_COUNT != STRESS_SAMPLES) {
+		STRESS_TIMES[STRESS_COUNT++] = StressNanos() - start;
+	}
+
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		fake = FakeOfSlot(i);
+		STRESS_CHECK(fake != -2, "slot %d is attached to a node that never existed", i);
+		STRESS_CHECK((fake != -1) == (SEEN_CONNECTED[i] != GAMEPAD_FALSE), "slot %d connection was not reported", i);
+		for (j = 0; j != i; ++j) {
+			STRESS_CHECK(fake < 0 || FakeOfSlot(j) != fake, "device %d is in slots %d and %d", fake, j, i);
+		}
+	}
+}
+
+/* Update until the monitor has delivered everything */
+static void StressSettle(void) {
+	int n;
+	for (n = 0; n != FAKE_QUEUE * 2 && FAKE_MONITOR != NULL && FAKE_MONITOR->count != 0; ++n) {
+		StressUpdate();
+	}
+	StressUpdate();
+	STRESS_CHECK(FAKE_MONITOR == NULL || FAKE_MONITOR->count == 0, "monitor events left after %d updates", n);
+}
+
+static int StressConnected(void) {
+	int i, count = 0;
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		count += (STATE[i].flags & FLAG_CONNECTED) != 0 ? 1 : 0;
+	}
+	return count;
+}
+
+static int compare_nanos(const void* a, const void* b) {
+	unsigned long long x = *(const unsigned long long*)a, y = *(const unsigned long long*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void StressBegin(void) {
+	STRESS_COUNT = 0;
+	SEEN_CONNECTS = SEEN_DISCONNECTS = 0;
+}
+
+static void StressReport(const char* phase) {
+	if (STRESS_QUIET) {
+		return;
+	}
+	qsort(STRESS_TIMES, STRESS_COUNT, sizeof(STRESS_TIMES[0]), compare_nanos);
+	printf("%-10s %7u updates  p50 %6.1f us  p99 %6.1f us  max %7.1f us  %5u connects %5u disconnects\n", phase,
+		STRESS_COUNT,
+		STRESS_COUNT != 0 ? STRESS_TIMES[STRESS_COUNT / 2] / 1000.0 : 0.0,
+		STRESS_COUNT != 0 ? STRESS_TIMES[(STRESS_COUNT - 1) * 99 / 100] / 1000.0 : 0.0,
+		STRESS_COUNT != 0 ? STRESS_TIMES[STRESS_COUNT - 1] / 1000.0 : 0.0,
+		SEEN_CONNECTS, SEEN_DISCONNECTS);
+}
+
+static void StressUnplugAll(void) {
+	int i;
+	for (i = 0; i != FAKE_COUNT; ++i) {
+		FakeUnplug(i);
+	}
+	StressSettle();
+}
+
+/* ---- phases ---- */
+
+/* Plug and unplug at random, several changes per update */
+static void PhaseChurn(int cycles) {
+	int n, k;
+
+	StressBegin();
+	for (n = 0; n != cycles; ++n) {
+		for (k = rand() % 4; k >= 0; --k) {
+			int i = rand() % FAKE_COUNT;
+			if (FAKES[i].plugged) {
+				FakeUnplug(i);
+			} else {
+				FakePlug(i, GAMEPAD_TRUE);
+			}
+		}
+		StressUpdate();
+	}
+	StressSettle();
+	STRESS_CHECK(StressConnected() <= GAMEPAD_COUNT, "too many slots in use");
+	StressUnplugAll();
+	STRESS_CHECK(StressConnected() == 0, "%d slots still connected after unplugging everything", StressConnected());
+	StressReport("churn");
+}
+
+/* Devices stream input and vanish with reads posted and data unread */
+static void PhaseRemoval(int cycles) {
+	int n, i;
+
+	StressBegin();
+	for (i = 0; i != GAMEPAD_COUNT; ++i) {
+		FakePlug(i, GAMEPAD_TRUE);
+	}
+	StressSettle();
+
+	for (n = 0; n != cycles; ++n) {
+		for (i = 0; i != FAKE_COUNT; ++i) {
+			FakeFeed(i, 1 + rand() % FAKE_BURST);
+		}
+		i = rand() % FAKE_COUNT;
+		if (rand() % 8 == 0) {
+			if (FAKES[i].plugged) {
+				/* sometimes the remove arrives while the node still has data */
+				if (rand() % 2 == 0) {
+					FakeFeed(i, FAKE_BURST);
+				}
+				FakeUnplug(i);
+			} else {
+				FakePlug(i, GAMEPAD_TRUE);
+			}
+		}
+		StressUpdate();
+	}
+	StressUnplugAll();
+	STRESS_CHECK(StressConnected() == 0, "%d slots still connected after unplugging everything", StressConnected());
+	StressReport("removal");
+}
+
+/* More devices than slots, and nodes that are gone before the add is handled */
+static void PhaseExhaust(int cycles) {
+	int n, i, fds;
+
+	StressBegin();
+	for (n = 0; n != cycles / 100 + 1; ++n) {
+		fds = StressOpenFds();
+		for (i = 0; i != FAKE_COUNT; ++i) {
+			FakePlug(i, GAMEPAD_TRUE);
+		}
+		StressSettle();
+		STRESS_CHECK(StressConnected() == GAMEPAD_COUNT, "%d of %d slots in use", StressConnected(), GAMEPAD_COUNT);
+		/* one descriptor per attached node, and one per FIFO the harness holds */
+		STRESS_CHECK(StressOpenFds() == fds + GAMEPAD_COUNT + FAKE_COUNT, "%d descriptors for %d devices",
+			StressOpenFds() - fds, GAMEPAD_COUNT);
+
+		/* a freed slot doesn't pick up a device announced while all were taken */
+		FakeUnplug(0);
+		StressSettle();
+		STRESS_CHECK(StressConnected() == GAMEPAD_COUNT - 1, "%d slots in use after one unplug", StressConnected());
+
+		/* added and removed before the update sees the add */
+		FakePlug(0, GAMEPAD_TRUE);
+		FakeUnplug(0);
+		StressSettle();
+		STRESS_CHECK(StressConnected() == GAMEPAD_COUNT - 1, "%d slots in use after a vanished node", StressConnected());
+
+		StressUnplugAll();
+		STRESS_CHECK(StressOpenFds() == fds, "%d descriptors leaked", StressOpenFds() - fds);
+	}
+	StressReport("exhaust");
+}
+
+/* A flaky link announces the new node before removing the old one */
+static void PhaseFlaky(int cycles) {
+	FAKE old;
+	int n, slot;
+
+	StressBegin();
+	FakePlug(0, GAMEPAD_TRUE);
+	StressSettle();
+	for (slot = 0; slot != GAMEPAD_COUNT && FakeOfSlot(slot) != 0; ++slot) {
+	}
+
+	for (n = 0; n != cycles; ++n) {
+		old = FAKES[0];
+		FakePlug(0, GAMEPAD_TRUE);
+		FakeFeed(0, FAKE_BURST);
+		/* the old node's remove comes later and must not drop the new one */
+		if (old.writer != -1) {
+			close(old.writer);
+		}
+		unlink(old.devnode);
+		old.plugged = GAMEPAD_FALSE;
+		FakeAnnounce(&old, "remove");
+		StressSettle();
+		STRESS_CHECK(FakeOfSlot(slot) == 0, "reconnected device left slot %d", slot);
+	}
+	StressUnplugAll();
+	StressReport("flaky");
+}
+
+/* Devices present at startup, over repeated init and shutdown */
+static void PhaseRestart(int cycles) {
+	int n, i;
+
+	StressBegin();
+	for (n = 0; n != cycles / 100 + 1; ++n) {
+		for (i = 0; i != GAMEPAD_COUNT - 1; ++i) {
+			FakePlug(i, GAMEPAD_FALSE);
+		}
+		memset(SEEN_CONNECTED, 0, sizeof(SEEN_CONNECTED));
+		GamepadInit();
+		STRESS_CHECK(StressConnected() == GAMEPAD_COUNT - 1, "%d devices found at startup", StressConnected());
+		for (i = 0; i != GAMEPAD_COUNT - 1; ++i) {
+			FakeFeed(i, FAKE_BURST);
+		}
+		StressUpdate();
+		GamepadShutdown();
+		for (i = 0; i != FAKE_COUNT; ++i) {
+			FakeUnplug(i);
+		}
+	}
+	StressReport("restart");
+}
+
+/* Every phase once */
+static void StressRun(int cycles) {
+	memset(SEEN_CONNECTED, 0, sizeof(SEEN_CONNECTED));
+	GamepadInit();
+	if (!STRESS_QUIET) {
+		printf("io_uring %s, %d slots, %d fake devices\n", GamepadUringActive() ? "on" : "off", GAMEPAD_COUNT, FAKE_COUNT);
+	}
+
+	PhaseChurn(cycles);
+	PhaseRemoval(cycles);
+	PhaseExhaust(cycles);
+	PhaseFlaky(cycles / 10);
+	GamepadShutdown();
+
+	PhaseRestart(cycles);
+}
+
+int main(int argc, char** argv) {
+	int cycles = argc > 1 ? atoi(argv[1]) : 10000;
+	int fds, i;
+	size_t heap;
+
+	strcpy(FAKE_DIR, "/tmp/gamepad-stress-XXXXXX");
+	if (mkdtemp(FAKE_DIR) == NULL) {
+		fprintf(stderr, "stress: cannot create a scratch directory\n");
+		return 1;
+	}
+	for (i = 0; i != FAKE_COUNT; ++i) {
+		FAKES[i].writer = -1;
+	}
+	srand(1);
+	GamepadSubscribe(GAMEPAD_MASK_ALL, GAMEPAD_MASK_ALL, GAMEPAD_MASK_ALL, 0, onevent, NULL);
+
+	/* a silent round first, so stdio buffers and the allocator's caches are warm */
+	STRESS_QUIET = GAMEPAD_TRUE;
+	StressRun(cycles);
+	STRESS_QUIET = GAMEPAD_FALSE;
+	printf("\n");
+	fds = StressOpenFds();
+	heap = StressHeap();
+
+	StressRun(cycles);
+
+	STRESS_CHECK(StressOpenFds() == fds, "%d descriptors leaked", StressOpenFds() - fds);
+	STRESS_CHECK(StressHeap() <= heap, "%lu heap bytes leaked", (unsigned long)(StressHeap() - heap));
+	STRESS_CHECK(FAKE_OBJECTS == 0, "%d udev objects leaked", FAKE_OBJECTS);
+	rmdir(FAKE_DIR);
+
+	printf("%s: %d failures\n", STRESS_FAILURES == 0 ? "ok" : "FAILED", STRESS_FAILURES);
+	return STRESS_FAILURES == 0 ? 0 : 1;
+}